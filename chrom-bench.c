@@ -0,0 +1,201 @@
+/** Times the word-level chromosome kernels against the equivalent operations
+ * built on the per-bit callback API
+ * @file chrom-bench.c */
+#include "chromosome.h"
+#include "mono-clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/** Number of bit operations (num_bits * repetitions) timed per measurement */
+#define BITS_PER_RUN            (1 << 22)
+/** Number of distinct chromosomes cycled through so that the working set
+ * is not a single cache line */
+#define NUM_CHROMS              64
+
+/** Prints a table row for a legacy vs word-level measurement */
+static void print_row(const char *op, size_t num_bits, double legacy_ns,
+                      double word_ns);
+
+/* Legacy implementations through the callback API; these mirror what
+ * chromosome.c did before the word-level kernels existed, including drawing
+ * from the C library rand() */
+struct legacy_ucx_context {
+        const chrom_t *parent1;
+        const chrom_t *parent2;
+        size_t bit_index;
+};
+static bool legacy_ucx_bit(void *ucx_context) {
+        struct legacy_ucx_context *context
+                = (struct legacy_ucx_context *)ucx_context;
+        size_t i = context->bit_index++;
+        const chrom_t *parent = (rand() % 2) ? context->parent1
+                                             : context->parent2;
+        return parent->words[i / WORD_BITS] & ((uint64_t)1 << (i % WORD_BITS));
+}
+static void legacy_ucx(chrom_t *child, const chrom_t *parent1,
+                       const chrom_t *parent2) {
+        struct legacy_ucx_context context = {parent1, parent2, 0};
+        chrom_bitwise_write(child, &context, legacy_ucx_bit);
+}
+static bool legacy_mutate_bit(bool bit_val, void *prob_div) {
+        bool is_mutated = (rand() % *(size_t *)prob_div) == 0;
+        return (!is_mutated && bit_val) || (is_mutated && !bit_val);
+}
+static void legacy_mutate(chrom_t *chrom) {
+        size_t probability_divisor = chrom->num_bits;
+        chrom_bitwise_rnw(chrom, &probability_divisor, legacy_mutate_bit);
+}
+static void legacy_invert_byte(uint8_t *byte, void *no_context) {
+        *byte = ~(*byte);
+}
+static void legacy_invert(chrom_t *chrom) {
+        chrom_bytewise(chrom, NULL, legacy_invert_byte);
+}
+static void legacy_count1s_bit(bool bit_val, void *count) {
+        *(size_t *)count += bit_val;
+}
+static size_t legacy_count1s(const chrom_t *chrom) {
+        size_t count = 0;
+        chrom_bitwise_read(chrom, &count, legacy_count1s_bit);
+        return count;
+}
+struct legacy_fitness_context {
+        const long long *item_vals;
+        long long diff;
+};
+static void legacy_fitness_bit(bool bit_val, void *fitness_context) {
+        struct legacy_fitness_context *context
+                = (struct legacy_fitness_context *)fitness_context;
+        if (bit_val) {
+                context->diff -= *context->item_vals;
+        } else {
+                context->diff += *context->item_vals;
+        }
+        context->item_vals++;
+}
+static long long legacy_fitness(const chrom_t *chrom,
+                                const long long *item_vals) {
+        struct legacy_fitness_context context = {item_vals, 0};
+        chrom_bitwise_read(chrom, &context, legacy_fitness_bit);
+        return context.diff;
+}
+/* Word-level fitness walk, as done in number-partition.c */
+static long long word_fitness(const chrom_t *chrom,
+                              const long long *item_vals, long long total) {
+        unsigned long long set1_sum = 0;
+        for (size_t i=0; i<BITS2WORDS(chrom->num_bits); i++) {
+                uint64_t word = chrom->words[i];
+                while (word != 0) {
+                        set1_sum += item_vals[i * WORD_BITS
+                                              + __builtin_ctzll(word)];
+                        word &= word - 1;
+                }
+        }
+        return (long long)((unsigned long long)total - 2 * set1_sum);
+}
+
+int main(void) {
+        static const size_t sizes[] = {10, 100, 1000};
+        /* keeps the optimizer from discarding results */
+        volatile long long sink = 0;
+        rng_t rng;
+        rng_seed(&rng, 1);
+        printf("%-10s %6s %14s %14s %9s\n",
+               "operation", "N", "callback ns", "word ns", "speedup");
+        for (size_t s=0; s<sizeof(sizes)/sizeof(*sizes); s++) {
+                size_t num_bits = sizes[s];
+                size_t reps = BITS_PER_RUN / num_bits;
+                chrom_t *chroms[NUM_CHROMS];
+                for (size_t i=0; i<NUM_CHROMS; i++) {
+                        chroms[i] = chrom_rand(num_bits, &rng);
+                }
+                chrom_t *child = chrom_malloc(num_bits);
+                long long *item_vals = malloc(sizeof(*item_vals) * num_bits);
+                long long total = 0;
+                for (size_t i=0; i<num_bits; i++) {
+                        item_vals[i] = rng_below(&rng, INT32_MAX);
+                        total += item_vals[i];
+                }
+                double t0, legacy_ns, word_ns;
+
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        legacy_ucx(child, chroms[r % NUM_CHROMS],
+                                   chroms[(r + 1) % NUM_CHROMS]);
+                }
+                legacy_ns = (mono_now_ns() - t0) / reps;
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        words_ucx(child->words, chroms[r % NUM_CHROMS]->words,
+                                  chroms[(r + 1) % NUM_CHROMS]->words,
+                                  num_bits, &rng);
+                }
+                word_ns = (mono_now_ns() - t0) / reps;
+                print_row("ucx", num_bits, legacy_ns, word_ns);
+
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        legacy_mutate(chroms[r % NUM_CHROMS]);
+                }
+                legacy_ns = (mono_now_ns() - t0) / reps;
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        words_mutate(chroms[r % NUM_CHROMS]->words, num_bits,
+                                     1.0 / num_bits, &rng);
+                }
+                word_ns = (mono_now_ns() - t0) / reps;
+                print_row("mutate", num_bits, legacy_ns, word_ns);
+
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        legacy_invert(chroms[r % NUM_CHROMS]);
+                }
+                legacy_ns = (mono_now_ns() - t0) / reps;
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        words_invert(chroms[r % NUM_CHROMS]->words, num_bits);
+                }
+                word_ns = (mono_now_ns() - t0) / reps;
+                print_row("invert", num_bits, legacy_ns, word_ns);
+
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        sink += legacy_count1s(chroms[r % NUM_CHROMS]);
+                }
+                legacy_ns = (mono_now_ns() - t0) / reps;
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        sink += words_count1s(chroms[r % NUM_CHROMS]->words,
+                                              num_bits);
+                }
+                word_ns = (mono_now_ns() - t0) / reps;
+                print_row("popcount", num_bits, legacy_ns, word_ns);
+
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        sink += legacy_fitness(chroms[r % NUM_CHROMS],
+                                               item_vals);
+                }
+                legacy_ns = (mono_now_ns() - t0) / reps;
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        sink += word_fitness(chroms[r % NUM_CHROMS],
+                                             item_vals, total);
+                }
+                word_ns = (mono_now_ns() - t0) / reps;
+                print_row("fitness", num_bits, legacy_ns, word_ns);
+
+                for (size_t i=0; i<NUM_CHROMS; i++) {
+                        chrom_free(chroms[i]);
+                }
+                chrom_free(child);
+                free(item_vals);
+        }
+        return 0;
+}
+
+static void print_row(const char *op, size_t num_bits, double legacy_ns,
+                      double word_ns) {
+        printf("%-10s %6zu %14.1f %14.1f %8.1fx\n",
+               op, num_bits, legacy_ns, word_ns, legacy_ns / word_ns);
+}
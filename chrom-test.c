@@ -1,13 +1,16 @@
 #include "chromosome.h"
 #include <stdio.h>
+#include <time.h>
 
 #define NUM_RAND_CHROM          20
 #define CHROM_NUM_ITEMS         20
 #define NUM_CROSSOVERS          20
 
 int main(void) {
+        rng_t rng;
+        rng_seed(&rng, time(NULL));
         for (size_t i=0; i<NUM_RAND_CHROM; i++) {
-                chrom_t *chrom = chrom_rand(CHROM_NUM_ITEMS);
+                chrom_t *chrom = chrom_rand(CHROM_NUM_ITEMS, &rng);
                 printf("rand chromosome #%zu:\n", i);
                 chrom_print(chrom);
                 printf("inverted:\n");
@@ -17,22 +20,49 @@ int main(void) {
         }
         putchar('\n');
         for (size_t i=0; i<NUM_CROSSOVERS; i++) {
-                chrom_t *parent1 = chrom_rand(CHROM_NUM_ITEMS);
+                chrom_t *parent1 = chrom_rand(CHROM_NUM_ITEMS, &rng);
                 printf("parent1:\n");
                 chrom_print(parent1);
-                chrom_t *parent2 = chrom_rand(CHROM_NUM_ITEMS);
+                chrom_t *parent2 = chrom_rand(CHROM_NUM_ITEMS, &rng);
                 printf("parent2:\n");
                 chrom_print(parent2);
-                chrom_t *child = chrom_ucx(parent1, parent2);
+                chrom_t *child = chrom_ucx(parent1, parent2, &rng);
                 printf("child from crossover:\n");
                 chrom_print(child);
                 printf("mutating child...\n");
-                chrom_mutate(child);
+                chrom_mutate(child, &rng);
                 printf("mutated:\n");
                 chrom_print(child);
                 chrom_free(parent1);
                 chrom_free(parent2);
                 chrom_free(child);
         }
+        putchar('\n');
+        for (size_t i=0; i<NUM_CROSSOVERS; i++) {
+                /* all 0s and all 1s parents show where the cuts fall */
+                chrom_t *parent1 = chrom_malloc(CHROM_NUM_ITEMS);
+                chrom_t *parent2 = chrom_malloc(CHROM_NUM_ITEMS);
+                for (size_t w=0; w<BITS2WORDS(CHROM_NUM_ITEMS); w++) {
+                        parent1->words[w] = 0;
+                        parent2->words[w] = 0;
+                }
+                words_invert(parent2->words, CHROM_NUM_ITEMS);
+                chrom_t *child = chrom_malloc(CHROM_NUM_ITEMS);
+                printf("parent1:\n");
+                chrom_print(parent1);
+                printf("parent2:\n");
+                chrom_print(parent2);
+                words_1px(child->words, parent1->words, parent2->words,
+                          CHROM_NUM_ITEMS, &rng);
+                printf("child from one-point crossover:\n");
+                chrom_print(child);
+                words_2px(child->words, parent1->words, parent2->words,
+                          CHROM_NUM_ITEMS, &rng);
+                printf("child from two-point crossover:\n");
+                chrom_print(child);
+                chrom_free(parent1);
+                chrom_free(parent2);
+                chrom_free(child);
+        }
         return 0;
 }
@@ -3,11 +3,14 @@
 #include "chromosome.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+/** Number of crossover mask words generated per call to rng_fill */
+#define MASK_CHUNK              16
 
 static void invert_if_needed(chrom_t *chrom) {
-        if (chrom->bytes[0] & INITIAL_BIT) {
-                chrom_invert(chrom);
-        }
+        words_normalize(chrom->words, chrom->num_bits);
 }
 
 chrom_t *chrom_malloc(size_t num_bits) {
@@ -15,12 +18,9 @@ chrom_t *chrom_malloc(size_t num_bits) {
         tmp->num_bits = num_bits;
         return tmp;
 }
-static void rand_byte(uint8_t *byte, void *no_context) {
-        *byte = rand();
-}
-chrom_t *chrom_rand(size_t num_bits) {
+chrom_t *chrom_rand(size_t num_bits, rng_t *rng) {
         chrom_t *tmp = chrom_malloc(num_bits);
-        chrom_bytewise(tmp, NULL, rand_byte);
+        words_rand(tmp->words, num_bits, rng);
         invert_if_needed(tmp);
         return tmp;
 }
@@ -61,7 +61,11 @@ static void write_byte(uint8_t *byte, void *chrom_bitwise_context) {
 void chrom_bitwise_write(chrom_t *chrom, void *context,
                          bool (*func)(void *context)) {
         struct chrom_bitwise_context tmp = {chrom->num_bits, context, func};
-        chrom_bytewise((chrom_t *)chrom, &tmp, write_byte);
+        /* chrom_bytewise reads every word it writes back, and the chromosome
+         * may be fresh from chrom_malloc */
+        memset(chrom->words, 0,
+               sizeof(uint64_t) * BITS2WORDS(chrom->num_bits));
+        chrom_bytewise(chrom, &tmp, write_byte);
 }
 static void rnw_byte(uint8_t *byte, void *chrom_bitwise_context) {
         struct chrom_bitwise_context *context
@@ -79,52 +83,29 @@ void chrom_bitwise_rnw(chrom_t *chrom, void *context,
         chrom_bytewise((chrom_t *)chrom, &tmp, rnw_byte);
 }
 
-static void invert_byte(uint8_t *byte, void *no_context) {
-        *byte = ~(*byte);
-}
 void chrom_invert(chrom_t *chrom) {
-        chrom_bytewise(chrom, NULL, invert_byte);
-}
-struct ucx_context {
-        const chrom_t *parent1;
-        const chrom_t *parent2;
-        size_t byte_index;
-        uint8_t byte_bit_index;;
-};
-static bool ucx_bit(void *ucx_context) {
-        struct ucx_context *context = (struct ucx_context *)ucx_context;
-        if (context->byte_bit_index == BITS) {
-                context->byte_bit_index = 0;
-                context->byte_index++;
-        }
-        bool is_parent1_chosen = rand() % 2;
-        bool bit_val = (is_parent1_chosen
-                        * (context->parent1->bytes[context->byte_index]
-                           & (INITIAL_BIT << context->byte_bit_index))
-                       | (!is_parent1_chosen
-                          * (context->parent2->bytes[context->byte_index]
-                             & (INITIAL_BIT << context->byte_bit_index))));
-        context->byte_bit_index++;
-        return bit_val;
+        words_invert(chrom->words, chrom->num_bits);
 }
 /* Uniform crossover */
-chrom_t *chrom_ucx(const chrom_t *parent1, const chrom_t *parent2) {
+chrom_t *chrom_ucx(const chrom_t *parent1, const chrom_t *parent2,
+                   rng_t *rng) {
         chrom_t *tmp = chrom_malloc(parent1->num_bits);
-        struct ucx_context context = {parent1, parent2, 0, 0};
-        chrom_bitwise_write(tmp, &context, ucx_bit);
+        words_ucx(tmp->words, parent1->words, parent2->words,
+                  parent1->num_bits, rng);
         invert_if_needed(tmp);
         return tmp;
 }
-static bool mutate_bit(bool bit_val, void *prob_div) {
-        bool is_mutated = (rand() % *(size_t *)prob_div) == 0;
-        return (!is_mutated && bit_val) || (is_mutated && !bit_val);
-}
 /* Uniform probabilistic mutation */
-void chrom_mutate(chrom_t *chrom) {
-        size_t probability_divisor = chrom->num_bits;
-        chrom_bitwise_rnw(chrom, &probability_divisor, mutate_bit);
+void chrom_mutate(chrom_t *chrom, rng_t *rng) {
+        chrom_mutate_rate(chrom, 1.0 / chrom->num_bits, rng);
+}
+void chrom_mutate_rate(chrom_t *chrom, double rate, rng_t *rng) {
+        words_mutate(chrom->words, chrom->num_bits, rate, rng);
         invert_if_needed(chrom);
 }
+size_t chrom_count1s(const chrom_t *chrom) {
+        return words_count1s(chrom->words, chrom->num_bits);
+}
 
 static void print_bit(bool bit_val, void *no_context) {
         printf("%d", bit_val);
@@ -158,13 +139,150 @@ void byte_bitwise_rnw(uint8_t *byte, uint8_t num_bits, void *context,
                         | (bit_manip * func(*byte & bit_manip, context));
         }
 }
-/* Will not read byte; can be uninitialized */
+/* each byte is read out of its word and merged back, so the words must be
+ * initialized */
 void chrom_bytewise(chrom_t *chrom, void *context,
                     void (*func)(uint8_t *byte, void *context)) {
         size_t bytes = BITS2BYTES(chrom->num_bits);
         for (size_t i=0; i<bytes; i++) {
-                func(chrom->bytes+i, context);
+                uint64_t *word = chrom->words + i / (WORD_BITS / BITS);
+                unsigned shift = (i % (WORD_BITS / BITS)) * BITS;
+                uint8_t byte = *word >> shift;
+                func(&byte, context);
+                *word = (*word & ~((uint64_t)UINT8_MAX << shift))
+                        | ((uint64_t)byte << shift);
+        }
+        if (bytes != 0) {
+                chrom->words[BITS2WORDS(chrom->num_bits) - 1]
+                        &= TAIL_MASK(chrom->num_bits);
         }
 }
 /* LOW-LEVEL API */
 
+/* WORD-LEVEL API */
+void words_rand(uint64_t *words, size_t num_bits, rng_t *rng) {
+        size_t num_words = BITS2WORDS(num_bits);
+        rng_fill(rng, words, num_words);
+        if (num_words != 0) {
+                words[num_words - 1] &= TAIL_MASK(num_bits);
+        }
+}
+void words_invert(uint64_t *words, size_t num_bits) {
+        size_t num_words = BITS2WORDS(num_bits);
+        for (size_t i=0; i<num_words; i++) {
+                words[i] = ~words[i];
+        }
+        if (num_words != 0) {
+                words[num_words - 1] &= TAIL_MASK(num_bits);
+        }
+}
+void words_ucx(uint64_t *child, const uint64_t *parent1,
+               const uint64_t *parent2, size_t num_bits, rng_t *rng) {
+        size_t num_words = BITS2WORDS(num_bits);
+        uint64_t masks[MASK_CHUNK];
+        for (size_t i=0; i<num_words; i+=MASK_CHUNK) {
+                size_t chunk = (num_words - i < MASK_CHUNK)
+                               ? num_words - i
+                               : MASK_CHUNK;
+                rng_fill(rng, masks, chunk);
+                for (size_t j=0; j<chunk; j++) {
+                        child[i + j] = (parent1[i + j] & masks[j])
+                                       | (parent2[i + j] & ~masks[j]);
+                }
+        }
+}
+/** Writes into child the bits [lo, hi) of parent2 and the other bits of
+ * parent1, a word at a time so that child may alias either parent */
+static void words_range_cx(uint64_t *child, const uint64_t *parent1,
+                           const uint64_t *parent2, size_t num_bits,
+                           size_t lo, size_t hi) {
+        for (size_t i=0; i<BITS2WORDS(num_bits); i++) {
+                size_t word_lo = i * WORD_BITS;
+                size_t word_hi = word_lo + WORD_BITS;
+                uint64_t mask = 0;
+                if (lo < word_hi && hi > word_lo) {
+                        size_t from = (lo > word_lo) ? lo - word_lo : 0;
+                        size_t to = (hi < word_hi) ? hi - word_lo : WORD_BITS;
+                        mask = (to - from == WORD_BITS)
+                               ? ~(uint64_t)0
+                               : (((uint64_t)1 << (to - from)) - 1) << from;
+                }
+                child[i] = (parent1[i] & ~mask) | (parent2[i] & mask);
+        }
+}
+void words_1px(uint64_t *child, const uint64_t *parent1,
+               const uint64_t *parent2, size_t num_bits, rng_t *rng) {
+        size_t cut = rng_below(rng, num_bits + 1);
+        words_range_cx(child, parent1, parent2, num_bits, cut, num_bits);
+}
+void words_2px(uint64_t *child, const uint64_t *parent1,
+               const uint64_t *parent2, size_t num_bits, rng_t *rng) {
+        size_t cut1 = rng_below(rng, num_bits + 1);
+        size_t cut2 = rng_below(rng, num_bits + 1);
+        if (cut1 > cut2) {
+                size_t tmp = cut1;
+                cut1 = cut2;
+                cut2 = tmp;
+        }
+        words_range_cx(child, parent1, parent2, num_bits, cut1, cut2);
+}
+void words_mutate(uint64_t *words, size_t num_bits, double rate,
+                  rng_t *rng) {
+        if (!(rate > 0)) {
+                return;
+        }
+        if (rate >= 1) {
+                words_invert(words, num_bits);
+                return;
+        }
+        /* number of unflipped bits before the next flip is
+         * floor(log(U) / log(1 - rate)) */
+        double inv_log_q = 1 / log1p(-rate);
+        size_t i = 0;
+        while (true) {
+                double gap = floor(log(rng_unit(rng)) * inv_log_q);
+                if (gap >= (double)(num_bits - i)) {
+                        break;
+                }
+                i += (size_t)gap;
+                words[i / WORD_BITS] ^= (uint64_t)1 << (i % WORD_BITS);
+                i++;
+        }
+}
+size_t words_count1s(const uint64_t *words, size_t num_bits) {
+        size_t num_words = BITS2WORDS(num_bits);
+        size_t count = 0;
+        for (size_t i=0; i<num_words; i++) {
+                count += __builtin_popcountll(words[i]);
+        }
+        return count;
+}
+size_t words_distance(const uint64_t *words1, const uint64_t *words2,
+                      size_t num_bits) {
+        size_t num_words = BITS2WORDS(num_bits);
+        size_t count = 0;
+        for (size_t i=0; i<num_words; i++) {
+                count += __builtin_popcountll(words1[i] ^ words2[i]);
+        }
+        return count;
+}
+bool words_normalize(uint64_t *words, size_t num_bits) {
+        if (num_bits != 0 && (words[0] & INITIAL_BIT)) {
+                words_invert(words, num_bits);
+                return true;
+        }
+        return false;
+}
+uint64_t words_hash(const uint64_t *words, size_t num_bits) {
+        /* each word is folded in with a multiply and xor-shift mix, so that
+         * a flip in any bit spreads over the whole hash */
+        size_t num_words = BITS2WORDS(num_bits);
+        uint64_t hash = num_bits;
+        for (size_t i=0; i<num_words; i++) {
+                hash = (hash ^ words[i]) * 0x9e3779b97f4a7c15ULL;
+                hash ^= hash >> 32;
+        }
+        hash *= 0xd6e8feb86659fd93ULL;
+        return hash ^ (hash >> 32);
+}
+/* WORD-LEVEL API */
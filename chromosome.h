@@ -7,6 +7,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include "rng.h"
 
 /** Number of bits in a byte */
 #define BITS            8
@@ -18,21 +19,37 @@
 #define BITS2BYTES(NUM_BITS) \
         (((NUM_BITS) + BITS - 1) / BITS)
 
+/** Number of bits in a word (limb) of the chromosome */
+#define WORD_BITS       64
+/** Macro to convert bits to how many words are required to hold them */
+#define BITS2WORDS(NUM_BITS) \
+        (((NUM_BITS) + WORD_BITS - 1) / WORD_BITS)
+/** Mask of the bits of the last word which actually belong to the
+ * chromosome */
+#define TAIL_MASK(NUM_BITS) \
+        (((NUM_BITS) % WORD_BITS == 0) \
+         ? ~(uint64_t)0 \
+         : (((uint64_t)1 << ((NUM_BITS) % WORD_BITS)) - 1))
+
 /** Macro to convert bits to the size of the chromosome required to hold that
  * many bits */
 #define CHROM_SIZE(NUM_BITS) \
-        (offsetof(chrom_t, bytes) + BITS2BYTES(NUM_BITS))
+        (offsetof(chrom_t, words) + sizeof(uint64_t) * BITS2WORDS(NUM_BITS))
 /** Typedef for struct chromosome */
 typedef struct chromosome chrom_t;
 /** Structure representing a binary chromosome; its unfitness is always
- * uninitialized when allocated */
+ * uninitialized when allocated
+ *
+ * Bit i of the chromosome is bit (i % WORD_BITS) of words[i / WORD_BITS].
+ * Bits past num_bits in the last word are always kept 0 so that whole-word
+ * operations (popcount, comparison) need no special casing. */
 struct chromosome {
         /** Unfitness variable to be determined externally */
         long long unfitness;
-        /** Number of bits contained in bytes array */
+        /** Number of bits contained in words array */
         size_t num_bits;
-        /** Byte array to hold bits */
-        uint8_t bytes[];
+        /** Word array to hold bits */
+        uint64_t words[];
 };
 
 /** Allocates a chromosome big enough to fit num_bits
@@ -40,10 +57,10 @@ struct chromosome {
  * @post                bytes are uninitialized; space for them is
  *                      allocated */
 chrom_t *chrom_malloc(size_t num_bits);
-/** Allocates a chromosome with num_bits random bits
+/** Allocates a chromosome with num_bits random bits drawn from rng
  * @post                unfitness is uninitialized
  * @post                leading bit of entire chromosome is always 0 */
-chrom_t *chrom_rand(size_t num_bits);
+chrom_t *chrom_rand(size_t num_bits, rng_t *rng);
 /** Frees space granted for chromosome */
 void chrom_free(chrom_t *chrom);
 
@@ -52,7 +69,7 @@ void chrom_free(chrom_t *chrom);
 void chrom_bitwise_read(const chrom_t *chrom, void *context,
                         void (*func)(bool bit_val, void *context));
 /** Writes each bit of the chromosome to the return value of func sequentially
- * without reading the original bit */
+ * without reading the original bit; the chromosome may be uninitialized */
 void chrom_bitwise_write(chrom_t *chrom, void *context,
                          bool (*func)(void *context));
 /** Reads each bit of the chromosome sequentially and passes it to func and
@@ -67,7 +84,8 @@ void chrom_invert(chrom_t *chrom);
  * @post                child chromosome's leading bit will always be 0;
  *                      this is guaranteed as the parents should follow this
  *                      pattern, but will also be enforced internally */
-chrom_t *chrom_ucx(const chrom_t *parent1, const chrom_t *parent2);
+chrom_t *chrom_ucx(const chrom_t *parent1, const chrom_t *parent2,
+                   rng_t *rng);
 /** Performs probabilistic mutation upon each bit of chromosome; average
  * mutation rate is 1 bit mutated across chromosome
  * @post                if the leading bit of chromosome is mutated to be 1,
@@ -76,11 +94,62 @@ chrom_t *chrom_ucx(const chrom_t *parent1, const chrom_t *parent2);
  *                      impact unfitness from if it were left uninverted
  * @post                chromosome's unfitness will be invalidated but
  *                      unaltered */
-void chrom_mutate(chrom_t *chrom);
+void chrom_mutate(chrom_t *chrom, rng_t *rng);
+/** Same as chrom_mutate but each bit is flipped with a probability of rate
+ * instead of 1/num_bits */
+void chrom_mutate_rate(chrom_t *chrom, double rate, rng_t *rng);
+
+/** Returns the number of bits set to 1 in the chromosome */
+size_t chrom_count1s(const chrom_t *chrom);
 
 /** Prints each bit of chromosome then prints a newline */
 void chrom_print(const chrom_t *chrom);
 
+/* WORD-LEVEL API */
+/* These operate directly on a chromosome's word array so that they can be
+ * shared by anything storing bits in the chromosome layout. None of them
+ * normalize the leading bit; see words_normalize. */
+/** Fills the words with num_bits random bits
+ * @post                padding bits past num_bits are 0 */
+void words_rand(uint64_t *words, size_t num_bits, rng_t *rng);
+/** Inverts every bit
+ * @post                padding bits past num_bits are 0 */
+void words_invert(uint64_t *words, size_t num_bits);
+/** Uniform crossover; each bit of child is taken from parent1 where a random
+ * mask word has a 1 and from parent2 otherwise
+ * @pre                 child may alias either parent */
+void words_ucx(uint64_t *child, const uint64_t *parent1,
+               const uint64_t *parent2, size_t num_bits, rng_t *rng);
+/** One-point crossover; child takes the bits below a random cut from
+ * parent1 and the rest from parent2
+ * @pre                 child may alias either parent */
+void words_1px(uint64_t *child, const uint64_t *parent1,
+               const uint64_t *parent2, size_t num_bits, rng_t *rng);
+/** Two-point crossover; child takes the bits between two random cuts from
+ * parent2 and the rest from parent1
+ * @pre                 child may alias either parent */
+void words_2px(uint64_t *child, const uint64_t *parent1,
+               const uint64_t *parent2, size_t num_bits, rng_t *rng);
+/** Flips each bit with a probability of rate; rather than drawing for every
+ * bit, the gaps between flipped bits are drawn from a geometric distribution
+ * so that the cost is proportional to the number of flips */
+void words_mutate(uint64_t *words, size_t num_bits, double rate,
+                  rng_t *rng);
+/** Returns the number of bits set to 1 */
+size_t words_count1s(const uint64_t *words, size_t num_bits);
+/** Returns the number of bits in which two chromosomes differ (Hamming
+ * distance) */
+size_t words_distance(const uint64_t *words1, const uint64_t *words2,
+                      size_t num_bits);
+/** Inverts the words if the leading bit is 1 so that it becomes 0; returns
+ * whether an inversion took place */
+bool words_normalize(uint64_t *words, size_t num_bits);
+/** Returns a 64-bit hash of the bits, so that equal chromosomes can be found
+ * without comparing them word by word
+ * @pre                 padding bits past num_bits are 0 */
+uint64_t words_hash(const uint64_t *words, size_t num_bits);
+/* WORD-LEVEL API */
+
 /* LOW-LEVEL API */
 /** Reads each bit in the byte sequentially and passes that bit value to func
  * @pre                 primarily used in conjunction with chrom_bytewise */
@@ -97,11 +166,12 @@ void byte_bitwise_write(uint8_t *byte, uint8_t num_bits, void *context,
 void byte_bitwise_rnw(uint8_t *byte, uint8_t num_bits, void *context,
                       bool (*func)(bool bit_val, void *context));
 /** Iterates over every byte in the chromosome and passes its address to func
- * @pre                 byte is never read by the function; safe to be
- *                      uninitialized
+ * @pre                 the words of the chromosome are initialized; each byte
+ *                      passed to func holds the current bits
  * @post                the function itself will not alter any part of the
  *                      chromosome; func, however, is permitted to alter the
- *                      bytes */
+ *                      bytes
+ * @post                padding bits past num_bits are reset to 0 */
 void chrom_bytewise(chrom_t *chrom, void *context,
                     void (*func)(uint8_t *byte, void *context));
 /* LOW-LEVEL API */
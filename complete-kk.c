@@ -0,0 +1,425 @@
+/** Implements the Complete Karmarkar-Karp search declared in differencing.h
+ *
+ * A node of the search tree is a list of partial partitions sorted by
+ * decreasing difference. Its children replace the two largest, a and b, with
+ * a - b (putting them on opposite sides, as the Largest Differencing Method
+ * does) or with a + b (putting them on the same side). A node whose largest
+ * difference is at least the sum of the others is a leaf: the others all go
+ * against the largest. Every choice merges b's representative item into
+ * a's, so a leaf's partition is recovered by coloring the merges along its
+ * path in reverse, as ldm_partition does.
+ *
+ * Each thread walks its subtree depth first with one frame per depth. A
+ * frame whose sum child is still unexplored is marked pending; idle threads
+ * steal the shallowest pending frame of another thread under its lock.
+ * @file complete-kk.c */
+#include "differencing.h"
+#include "chromosome.h"
+#include "fitness.h"
+#include "mono-clock.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+/** Number of nodes a thread visits between checks of the budget */
+#define CKK_CHECK_INTERVAL      1024
+
+/** Partial partition of a node */
+struct ckk_value {
+        /** Difference between the sides of the partial partition */
+        unsigned long long diff;
+        /** Item standing for the partial partition */
+        size_t rep;
+};
+/** Choice made at one depth of the path to a node: b's representative was
+ * merged into a's, on the same side if same is set */
+struct ckk_merge {
+        size_t a;
+        size_t b;
+        bool same;
+};
+/** Node at one depth of a thread's walk */
+struct ckk_frame {
+        /** Partial partitions sorted by decreasing difference; points into
+         * the thread's value pool */
+        struct ckk_value *vals;
+        size_t num_vals;
+        /** Sum of the differences of vals */
+        unsigned long long sum;
+        /** Sum child not yet explored nor stolen; set by the owner alone,
+         * cleared only under the owner's lock */
+        atomic_bool sum_pending;
+};
+/** State shared by all threads of a search */
+struct ckk_run {
+        size_t num_items;
+        size_t num_threads;
+        struct ckk_thread *threads;
+        /** No partition can have a smaller difference than this */
+        unsigned long long lower_bound;
+        unsigned long long node_limit;
+        /** Monotonic deadline in seconds; 0 means none */
+        double deadline;
+        atomic_ullong num_nodes;
+        atomic_size_t num_idle;
+        /** Set when the budget runs out or a perfect partition is found */
+        atomic_bool stop;
+        /** Set when stop was caused by the budget */
+        atomic_bool cut_short;
+        /** Difference of best_words; read without the lock to prune */
+        atomic_ullong best_diff;
+        pthread_mutex_t best_lock;
+        uint64_t *best_words;
+};
+/** State of one thread */
+struct ckk_thread {
+        struct ckk_run *run;
+        /** One frame per depth; depth d holds num_items - d values */
+        struct ckk_frame *frames;
+        struct ckk_value *pool;
+        /** Choices along the path to the current node, one per depth */
+        struct ckk_merge *path;
+        /** Depth of the node the thread's current subtree hangs from */
+        size_t root_depth;
+        pthread_mutex_t lock;
+        pthread_t thread;
+};
+
+/** Orders values by decreasing difference, ties by item index */
+static int value_cmp(const void *a, const void *b);
+/** Returns the offset of depth d's values in a thread's value pool */
+static size_t pool_offset(size_t num_items, size_t d);
+/** Fills frame d+1 with the difference child of frame d */
+static void diff_child(struct ckk_thread *thread, size_t d);
+/** Fills frame d+1 of to with the sum child of frame d of from */
+static void sum_child(struct ckk_thread *to, const struct ckk_thread *from,
+                      size_t d);
+/** Records a leaf at depth d if it beats the best partition so far */
+static void leaf(struct ckk_thread *thread, size_t d, unsigned long long diff);
+/** Walks the subtree hanging from frame thread->root_depth */
+static void walk(struct ckk_thread *thread);
+/** Moves the shallowest pending subtree of another thread into thread;
+ * returns false if there is none */
+static bool steal(struct ckk_thread *thread);
+/** Body of every thread */
+static void *run_thread(void *thread);
+
+void ckk_params_init(ckk_params_t *params) {
+        params->num_threads = 1;
+        params->time_limit = 0;
+        params->node_limit = 0;
+}
+unsigned long long ckk_partition(const long long *item_vals, size_t num_items,
+                                 const ckk_params_t *params, uint64_t *words,
+                                 ckk_stats_t *stats) {
+        double start = mono_now();
+        /* the differences and their sums are kept in 64 bits */
+        if (num_items == 0
+            || fitness_width(item_vals, num_items) == FITNESS_WIDE) {
+                unsigned long long diff = ldm_partition(item_vals, num_items,
+                                                        words);
+                if (stats != NULL) {
+                        stats->proven = (num_items == 0);
+                        stats->num_nodes = 0;
+                        stats->seconds = mono_now() - start;
+                }
+                return diff;
+        }
+        const size_t num_threads = (params->num_threads > 0)
+                                   ? params->num_threads
+                                   : 1;
+        struct ckk_run run = {
+                .num_items = num_items,
+                .num_threads = num_threads,
+                .threads = malloc(sizeof(struct ckk_thread) * num_threads),
+                .node_limit = params->node_limit,
+                .deadline = (params->time_limit > 0)
+                            ? start + params->time_limit
+                            : 0,
+                .best_words = words
+        };
+        atomic_init(&run.num_nodes, 0);
+        atomic_init(&run.num_idle, 0);
+        atomic_init(&run.stop, false);
+        atomic_init(&run.cut_short, false);
+        atomic_init(&run.best_diff, ULLONG_MAX);
+        pthread_mutex_init(&run.best_lock, NULL);
+        size_t pool_size = pool_offset(num_items, num_items);
+        for (size_t t=0; t<num_threads; t++) {
+                struct ckk_thread *thread = run.threads + t;
+                thread->run = &run;
+                thread->frames = malloc(sizeof(*thread->frames) * num_items);
+                thread->pool = malloc(sizeof(*thread->pool) * pool_size);
+                thread->path = malloc(sizeof(*thread->path) * num_items);
+                for (size_t d=0; d<num_items; d++) {
+                        thread->frames[d].vals = thread->pool
+                                                 + pool_offset(num_items, d);
+                        atomic_init(&thread->frames[d].sum_pending, false);
+                }
+                thread->root_depth = 0;
+                pthread_mutex_init(&thread->lock, NULL);
+        }
+        /* thread 0 starts from the root; the others steal from it */
+        struct ckk_frame *root = run.threads[0].frames;
+        root->num_vals = num_items;
+        root->sum = 0;
+        for (size_t i=0; i<num_items; i++) {
+                long long val = item_vals[i];
+                root->vals[i].diff = (val < 0) ? -(unsigned long long)val
+                                               : (unsigned long long)val;
+                root->vals[i].rep = i;
+                root->sum += root->vals[i].diff;
+        }
+        run.lower_bound = root->sum & 1;
+        qsort(root->vals, num_items, sizeof(*root->vals), value_cmp);
+        for (size_t t=1; t<num_threads; t++) {
+                atomic_fetch_add(&run.num_idle, 1);
+        }
+        for (size_t t=1; t<num_threads; t++) {
+                pthread_create(&run.threads[t].thread, NULL, run_thread,
+                               run.threads + t);
+        }
+        walk(run.threads);
+        run_thread(run.threads);
+        for (size_t t=1; t<num_threads; t++) {
+                pthread_join(run.threads[t].thread, NULL);
+        }
+        for (size_t t=0; t<num_threads; t++) {
+                free(run.threads[t].frames);
+                free(run.threads[t].pool);
+                free(run.threads[t].path);
+                pthread_mutex_destroy(&run.threads[t].lock);
+        }
+        free(run.threads);
+        pthread_mutex_destroy(&run.best_lock);
+        /* a negative item contributes its magnitude to the other side */
+        for (size_t i=0; i<num_items; i++) {
+                if (item_vals[i] < 0) {
+                        words[i / WORD_BITS] ^= (uint64_t)1 << (i % WORD_BITS);
+                }
+        }
+        words_normalize(words, num_items);
+        if (stats != NULL) {
+                stats->proven = !atomic_load(&run.cut_short);
+                stats->num_nodes = atomic_load(&run.num_nodes);
+                stats->seconds = mono_now() - start;
+        }
+        return atomic_load(&run.best_diff);
+}
+result_t *num_part_2way_ckk(const prob_set_t *ps, const ckk_params_t *params,
+                            ckk_stats_t *stats) {
+        chrom_t *chrom = chrom_malloc(ps->num_items);
+        ckk_partition(ps->item_vals, ps->num_items, params, chrom->words,
+                      stats);
+        result_t *res = result_malloc(chrom, ps->item_vals, 0);
+        chrom_free(chrom);
+        return res;
+}
+
+static int value_cmp(const void *a, const void *b) {
+        const struct ckk_value *va = (const struct ckk_value *)a;
+        const struct ckk_value *vb = (const struct ckk_value *)b;
+        if (va->diff != vb->diff) {
+                return (va->diff > vb->diff) ? -1 : 1;
+        }
+        return (va->rep > vb->rep) - (va->rep < vb->rep);
+}
+static size_t pool_offset(size_t num_items, size_t d) {
+        /* depths 0 .. d-1 hold num_items, num_items - 1, ... values */
+        return d * num_items - d * (d - 1) / 2;
+}
+static void diff_child(struct ckk_thread *thread, size_t d) {
+        const struct ckk_frame *frame = thread->frames + d;
+        struct ckk_frame *child = thread->frames + d + 1;
+        const struct ckk_value *rest = frame->vals + 2;
+        size_t num_rest = frame->num_vals - 2;
+        struct ckk_value merged = {
+                .diff = frame->vals[0].diff - frame->vals[1].diff,
+                .rep = frame->vals[0].rep
+        };
+        /* binary search for the first value smaller than the merged one */
+        size_t lo = 0;
+        size_t hi = num_rest;
+        while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (rest[mid].diff >= merged.diff) {
+                        lo = mid + 1;
+                } else {
+                        hi = mid;
+                }
+        }
+        memcpy(child->vals, rest, sizeof(*rest) * lo);
+        child->vals[lo] = merged;
+        memcpy(child->vals + lo + 1, rest + lo,
+               sizeof(*rest) * (num_rest - lo));
+        child->num_vals = num_rest + 1;
+        child->sum = frame->sum - 2 * frame->vals[1].diff;
+        thread->path[d] = (struct ckk_merge){
+                frame->vals[0].rep, frame->vals[1].rep, false
+        };
+}
+static void sum_child(struct ckk_thread *to, const struct ckk_thread *from,
+                      size_t d) {
+        const struct ckk_frame *frame = from->frames + d;
+        struct ckk_frame *child = to->frames + d + 1;
+        /* the sum is at least as large as every other value */
+        child->vals[0].diff = frame->vals[0].diff + frame->vals[1].diff;
+        child->vals[0].rep = frame->vals[0].rep;
+        memcpy(child->vals + 1, frame->vals + 2,
+               sizeof(*frame->vals) * (frame->num_vals - 2));
+        child->num_vals = frame->num_vals - 1;
+        child->sum = frame->sum;
+        if (to != from) {
+                memcpy(to->path, from->path, sizeof(*to->path) * d);
+        }
+        to->path[d] = (struct ckk_merge){
+                frame->vals[0].rep, frame->vals[1].rep, true
+        };
+}
+static void leaf(struct ckk_thread *thread, size_t d, unsigned long long diff) {
+        struct ckk_run *run = thread->run;
+        if (diff >= atomic_load_explicit(&run->best_diff,
+                                         memory_order_relaxed)) {
+                return;
+        }
+        pthread_mutex_lock(&run->best_lock);
+        if (diff < atomic_load(&run->best_diff)) {
+                uint64_t *words = run->best_words;
+                const struct ckk_frame *frame = thread->frames + d;
+                memset(words, 0, sizeof(*words) * BITS2WORDS(run->num_items));
+                /* the largest stays in set0 and the others go against it */
+                for (size_t i=1; i<frame->num_vals; i++) {
+                        size_t rep = frame->vals[i].rep;
+                        words[rep / WORD_BITS] |= (uint64_t)1
+                                                  << (rep % WORD_BITS);
+                }
+                for (size_t k=d; k-->0;) {
+                        const struct ckk_merge *merge = thread->path + k;
+                        uint64_t a_bit = (words[merge->a / WORD_BITS]
+                                          >> (merge->a % WORD_BITS)) & 1;
+                        uint64_t b_bit = merge->same ? a_bit : a_bit ^ 1;
+                        words[merge->b / WORD_BITS] |= b_bit
+                                                       << (merge->b
+                                                           % WORD_BITS);
+                }
+                atomic_store(&run->best_diff, diff);
+                if (diff <= run->lower_bound) {
+                        atomic_store(&run->stop, true);
+                }
+        }
+        pthread_mutex_unlock(&run->best_lock);
+}
+static void walk(struct ckk_thread *thread) {
+        struct ckk_run *run = thread->run;
+        size_t d = thread->root_depth;
+        unsigned long long num_nodes = 0;
+        while (true) {
+                if (++num_nodes % CKK_CHECK_INTERVAL == 0) {
+                        unsigned long long total = atomic_fetch_add(
+                                        &run->num_nodes, CKK_CHECK_INTERVAL)
+                                                   + CKK_CHECK_INTERVAL;
+                        if ((run->node_limit > 0 && total >= run->node_limit)
+                            || (run->deadline > 0
+                                && mono_now() >= run->deadline)) {
+                                atomic_store(&run->cut_short, true);
+                                atomic_store(&run->stop, true);
+                        }
+                }
+                if (atomic_load_explicit(&run->stop, memory_order_relaxed)) {
+                        break;
+                }
+                struct ckk_frame *frame = thread->frames + d;
+                unsigned long long largest = frame->vals[0].diff;
+                unsigned long long others = frame->sum - largest;
+                if (largest >= others) {
+                        leaf(thread, d, largest - others);
+                } else {
+                        diff_child(thread, d);
+                        /* the frame is not rewritten before the owner
+                         * backtracks through it under the lock, so a thief
+                         * may copy it from now on */
+                        atomic_store_explicit(&frame->sum_pending, true,
+                                              memory_order_release);
+                        d++;
+                        continue;
+                }
+                /* backtrack to the deepest frame whose sum child is left */
+                bool found = false;
+                pthread_mutex_lock(&thread->lock);
+                while (d > thread->root_depth) {
+                        d--;
+                        if (atomic_load_explicit(
+                                        &thread->frames[d].sum_pending,
+                                        memory_order_relaxed)) {
+                                atomic_store_explicit(
+                                        &thread->frames[d].sum_pending,
+                                        false, memory_order_relaxed);
+                                found = true;
+                                break;
+                        }
+                }
+                pthread_mutex_unlock(&thread->lock);
+                if (!found) {
+                        break;
+                }
+                sum_child(thread, thread, d);
+                d++;
+        }
+        /* leave no pending frame behind when stopped mid-walk */
+        pthread_mutex_lock(&thread->lock);
+        for (size_t k=thread->root_depth; k<run->num_items; k++) {
+                atomic_store_explicit(&thread->frames[k].sum_pending, false,
+                                      memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&thread->lock);
+        atomic_fetch_add(&run->num_nodes, num_nodes % CKK_CHECK_INTERVAL);
+}
+static bool steal(struct ckk_thread *thread) {
+        struct ckk_run *run = thread->run;
+        size_t self = thread - run->threads;
+        for (size_t v=1; v<run->num_threads; v++) {
+                struct ckk_thread *victim = run->threads
+                                            + (self + v) % run->num_threads;
+                pthread_mutex_lock(&victim->lock);
+                for (size_t d=victim->root_depth; d+1<run->num_items; d++) {
+                        if (atomic_load_explicit(
+                                        &victim->frames[d].sum_pending,
+                                        memory_order_acquire)) {
+                                atomic_store_explicit(
+                                        &victim->frames[d].sum_pending,
+                                        false, memory_order_relaxed);
+                                sum_child(thread, victim, d);
+                                thread->root_depth = d + 1;
+                                /* no longer idle before the victim can
+                                 * finish and count itself idle */
+                                atomic_fetch_sub(&run->num_idle, 1);
+                                pthread_mutex_unlock(&victim->lock);
+                                return true;
+                        }
+                }
+                pthread_mutex_unlock(&victim->lock);
+        }
+        return false;
+}
+static void *run_thread(void *thread_ptr) {
+        struct ckk_thread *thread = (struct ckk_thread *)thread_ptr;
+        struct ckk_run *run = thread->run;
+        /* thread 0 arrives here after its first walk; the others start
+         * idle */
+        if (thread == run->threads) {
+                atomic_fetch_add(&run->num_idle, 1);
+        }
+        while (!atomic_load_explicit(&run->stop, memory_order_relaxed)
+               && atomic_load(&run->num_idle) < run->num_threads) {
+                if (steal(thread)) {
+                        walk(thread);
+                        atomic_fetch_add(&run->num_idle, 1);
+                } else {
+                        sched_yield();
+                }
+        }
+        return NULL;
+}
@@ -0,0 +1,209 @@
+/** Implements function prototypes in differencing.h
+ *
+ * Every item starts as its own partial partition whose difference is the
+ * item's magnitude. Repeatedly replacing the two largest partial partitions
+ * with their difference commits their items to opposite sides, which is
+ * recorded as an edge from the smaller partition's representative item to
+ * the larger's. The edges form a tree that is colored in the reverse order
+ * of the merges once a single partition is left.
+ * @file differencing.c */
+#include "differencing.h"
+#include "chromosome.h"
+#include <stdlib.h>
+#include <limits.h>
+
+/** Partial partition in the max-heap */
+struct ldm_node {
+        /** Difference between the sides of the partial partition */
+        unsigned long long diff;
+        /** Item standing for the partial partition */
+        size_t rep;
+};
+
+/** Returns whether node a belongs above node b in the heap; ties are broken
+ * by item index so the result does not depend on the heap layout */
+static bool node_above(const struct ldm_node *a, const struct ldm_node *b);
+/** Moves heap[i] down until neither child belongs above it */
+static void sift_down(struct ldm_node *heap, size_t heap_size, size_t i);
+/** Fills heap with one partial partition per item, by magnitude */
+static void heap_init(struct ldm_node *heap, const long long *item_vals,
+                      size_t num_items);
+/** Merges the two largest partial partitions of the heap while more than
+ * num_left are left, or while more than one is and the largest difference
+ * does not fit in a long long; records each merge in parent and merged as
+ * ldm_partition describes and returns the number of partitions left */
+static size_t merge_largest(struct ldm_node *heap, size_t heap_size,
+                            size_t num_left, size_t *parent, size_t *merged,
+                            size_t *num_merged);
+
+unsigned long long ldm_partition(const long long *item_vals, size_t num_items,
+                                 uint64_t *words) {
+        for (size_t w=0; w<BITS2WORDS(num_items); w++) {
+                words[w] = 0;
+        }
+        if (num_items == 0) {
+                return 0;
+        }
+        struct ldm_node *heap = malloc(sizeof(*heap) * num_items);
+        /* parent[i] is the representative item i was merged against and
+         * merged[k] the item merged k-th */
+        size_t *parent = malloc(sizeof(*parent) * num_items);
+        size_t *merged = malloc(sizeof(*merged) * num_items);
+        heap_init(heap, item_vals, num_items);
+        size_t num_merged = 0;
+        merge_largest(heap, num_items, 1, parent, merged, &num_merged);
+        unsigned long long diff = heap[0].diff;
+        /* the last surviving representative is the root and stays in set0;
+         * every item merged is colored after the item it was merged
+         * against */
+        for (size_t k=num_merged; k-->0;) {
+                size_t i = merged[k];
+                size_t p = parent[i];
+                uint64_t parent_bit = (words[p / WORD_BITS]
+                                       >> (p % WORD_BITS)) & 1;
+                words[i / WORD_BITS] |= (parent_bit ^ 1) << (i % WORD_BITS);
+        }
+        /* a negative item contributes its magnitude to the other side */
+        for (size_t i=0; i<num_items; i++) {
+                if (item_vals[i] < 0) {
+                        words[i / WORD_BITS] ^= (uint64_t)1 << (i % WORD_BITS);
+                }
+        }
+        words_normalize(words, num_items);
+        free(heap);
+        free(parent);
+        free(merged);
+        return diff;
+}
+result_t *num_part_2way_kk(const prob_set_t *ps) {
+        chrom_t *chrom = chrom_malloc(ps->num_items);
+        ldm_partition(ps->item_vals, ps->num_items, chrom->words);
+        result_t *res = result_malloc(chrom, ps->item_vals, 0);
+        chrom_free(chrom);
+        return res;
+}
+ldm_reduction_t *ldm_reduce(const long long *item_vals, size_t num_items,
+                            size_t num_residual) {
+        if (num_residual == 0) {
+                num_residual = 1;
+        }
+        struct ldm_node *heap = malloc(sizeof(*heap) * num_items);
+        size_t *parent = malloc(sizeof(*parent) * num_items);
+        size_t *merged = malloc(sizeof(*merged) * num_items);
+        heap_init(heap, item_vals, num_items);
+        size_t num_merged = 0;
+        size_t heap_size = merge_largest(heap, num_items, num_residual,
+                                         parent, merged, &num_merged);
+        ldm_reduction_t *red = malloc(sizeof(*red));
+        red->num_items = num_items;
+        red->residual = prob_set_malloc(heap_size);
+        red->group = malloc(sizeof(*red->group) * num_items);
+        red->flip = calloc(BITS2WORDS(num_items), sizeof(*red->flip));
+        for (size_t k=0; k<heap_size; k++) {
+                /* only a lone partition can still be 2^63, and the side of
+                 * a lone partition makes no difference */
+                red->residual->item_vals[k] = (heap[k].diff > LLONG_MAX)
+                                              ? LLONG_MAX
+                                              : (long long)heap[k].diff;
+                red->group[heap[k].rep] = k;
+        }
+        /* each representative is on the side its residual item is put on,
+         * and every item merged is colored after the item it was merged
+         * against, as in ldm_partition */
+        for (size_t k=num_merged; k-->0;) {
+                size_t i = merged[k];
+                size_t p = parent[i];
+                uint64_t parent_bit = (red->flip[p / WORD_BITS]
+                                       >> (p % WORD_BITS)) & 1;
+                red->group[i] = red->group[p];
+                red->flip[i / WORD_BITS] |= (parent_bit ^ 1)
+                                            << (i % WORD_BITS);
+        }
+        for (size_t i=0; i<num_items; i++) {
+                if (item_vals[i] < 0) {
+                        red->flip[i / WORD_BITS] ^= (uint64_t)1
+                                                    << (i % WORD_BITS);
+                }
+        }
+        free(heap);
+        free(parent);
+        free(merged);
+        return red;
+}
+void ldm_expand(const ldm_reduction_t *red, const uint64_t *residual_words,
+                uint64_t *words) {
+        for (size_t w=0; w<BITS2WORDS(red->num_items); w++) {
+                size_t end = (w + 1) * WORD_BITS;
+                if (end > red->num_items) {
+                        end = red->num_items;
+                }
+                uint64_t word = 0;
+                for (size_t i=w*WORD_BITS; i<end; i++) {
+                        size_t g = red->group[i];
+                        word |= ((residual_words[g / WORD_BITS]
+                                  >> (g % WORD_BITS)) & 1)
+                                << (i % WORD_BITS);
+                }
+                words[w] = word ^ red->flip[w];
+        }
+        words_normalize(words, red->num_items);
+}
+void ldm_reduction_free(ldm_reduction_t *red) {
+        prob_set_free(red->residual);
+        free(red->group);
+        free(red->flip);
+        free(red);
+}
+
+static bool node_above(const struct ldm_node *a, const struct ldm_node *b) {
+        return (a->diff > b->diff) || (a->diff == b->diff && a->rep < b->rep);
+}
+static void sift_down(struct ldm_node *heap, size_t heap_size, size_t i) {
+        struct ldm_node node = heap[i];
+        while (true) {
+                size_t child = 2 * i + 1;
+                if (child >= heap_size) {
+                        break;
+                }
+                if (child + 1 < heap_size
+                    && node_above(heap + child + 1, heap + child)) {
+                        child++;
+                }
+                if (!node_above(heap + child, &node)) {
+                        break;
+                }
+                heap[i] = heap[child];
+                i = child;
+        }
+        heap[i] = node;
+}
+static void heap_init(struct ldm_node *heap, const long long *item_vals,
+                      size_t num_items) {
+        for (size_t i=0; i<num_items; i++) {
+                long long val = item_vals[i];
+                heap[i].diff = (val < 0) ? -(unsigned long long)val
+                                         : (unsigned long long)val;
+                heap[i].rep = i;
+        }
+        for (size_t i=num_items/2; i-->0;) {
+                sift_down(heap, num_items, i);
+        }
+}
+static size_t merge_largest(struct ldm_node *heap, size_t heap_size,
+                            size_t num_left, size_t *parent, size_t *merged,
+                            size_t *num_merged) {
+        while (heap_size > num_left
+               || (heap_size > 1 && heap[0].diff > LLONG_MAX)) {
+                struct ldm_node largest = heap[0];
+                heap[0] = heap[--heap_size];
+                sift_down(heap, heap_size, 0);
+                /* the second largest is replaced in place by the difference
+                 * rather than popped and pushed back */
+                parent[heap[0].rep] = largest.rep;
+                merged[(*num_merged)++] = heap[0].rep;
+                heap[0].diff = largest.diff - heap[0].diff;
+                heap[0].rep = largest.rep;
+                sift_down(heap, heap_size, 0);
+        }
+        return heap_size;
+}
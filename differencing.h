@@ -0,0 +1,102 @@
+#ifndef DIFFERENCING_H
+#define DIFFERENCING_H
+/** Header file to solve a 2-way number partitioning problem with the Largest
+ * Differencing Method of Karmarkar and Karp, or exactly with Korf's Complete
+ * Karmarkar-Karp search
+ * @file differencing.h */
+
+#include "number-partition.h"
+
+typedef struct ckk_params ckk_params_t;
+/** Limits of a ckk_partition search; initialize with ckk_params_init before
+ * changing individual fields */
+struct ckk_params {
+        /** Number of threads splitting the search tree; 0 means 1 */
+        size_t num_threads;
+        /** Wall-clock budget in seconds; 0 means none */
+        double time_limit;
+        /** Budget of search nodes over all threads; 0 means none */
+        unsigned long long node_limit;
+};
+typedef struct ckk_stats ckk_stats_t;
+/** Outcome of a ckk_partition search besides the partition itself */
+struct ckk_stats {
+        /** Whether the partition returned is optimal, i.e. the search was
+         * not cut short by its budget before finishing */
+        bool proven;
+        /** Number of search nodes visited over all threads */
+        unsigned long long num_nodes;
+        /** Wall-clock seconds spent searching */
+        double seconds;
+};
+typedef struct ldm_reduction ldm_reduction_t;
+/** Instance left by running the Largest Differencing Method only part of
+ * the way, along with what maps a partition of it back to the items */
+struct ldm_reduction {
+        /** One item per partial partition left, whose value is the
+         * difference between its sides; partitioning these partitions
+         * partitions every item with the same difference */
+        prob_set_t *residual;
+        /** Number of items of the original instance */
+        size_t num_items;
+        /** Residual item of the partial partition each item is in */
+        size_t *group;
+        /** Bit i is set, in the chromosome layout, if item i goes to the
+         * side opposite its residual item's */
+        uint64_t *flip;
+};
+
+/** Partitions num_items items with the Largest Differencing Method in
+ * O(num_items log num_items) time, writing set membership into words in the
+ * chromosome layout (bit i set if item i is in set1; BITS2WORDS(num_items)
+ * words, item 0 always in set0) and returning |sum of set0 - sum of set1|.
+ * Negative items are partitioned by magnitude and placed on the side that
+ * keeps that difference */
+unsigned long long ldm_partition(const long long *item_vals, size_t num_items,
+                                 uint64_t *words);
+/** Runs the Largest Differencing Method on a problem set, returning the same
+ * structure as num_part_2way (with no generations passed)
+ * @post                result must be freed (via result_free) */
+result_t *num_part_2way_kk(const prob_set_t *ps);
+
+/** Runs the Largest Differencing Method on num_items items until only
+ * num_residual (at least 1) partial partitions are left, committing the
+ * largest items to opposite sides first; fewer are left if a difference
+ * does not fit in a long long. Takes O(num_items log num_items) time and
+ * O(num_items) memory
+ * @post                reduction must be freed (via ldm_reduction_free) */
+ldm_reduction_t *ldm_reduce(const long long *item_vals, size_t num_items,
+                            size_t num_residual);
+/** Writes into words, normalized, the partition of the original items that
+ * the partition of red->residual in residual_words (chromosome layout)
+ * stands for */
+void ldm_expand(const ldm_reduction_t *red, const uint64_t *residual_words,
+                uint64_t *words);
+/** Frees a reduction along with its residual instance */
+void ldm_reduction_free(ldm_reduction_t *red);
+
+/** Fills params with no budget and a single thread */
+void ckk_params_init(ckk_params_t *params);
+/** Partitions num_items items with the Complete Karmarkar-Karp depth-first
+ * branch and bound, writing membership and returning the difference as
+ * ldm_partition does. The first partition found is the Largest Differencing
+ * Method's; the search stops early on a difference equal to the parity of
+ * the total, which no partition can beat. Threads steal the shallowest
+ * unexplored subtree of one another. If the budget runs out the best
+ * partition found so far is returned. Instances whose sum of absolute item
+ * values exceeds a long long are not searched and get the Largest
+ * Differencing Method's partition, unproven. Each thread keeps every node
+ * of its path, O(num_items^2) values, so the search is meant for instances of
+ * up to a few thousand items
+ * @param stats         filled in if not NULL */
+unsigned long long ckk_partition(const long long *item_vals, size_t num_items,
+                                 const ckk_params_t *params, uint64_t *words,
+                                 ckk_stats_t *stats);
+/** Runs ckk_partition on a problem set, returning the same structure as
+ * num_part_2way (with no generations passed)
+ * @param stats         filled in if not NULL
+ * @post                result must be freed (via result_free) */
+result_t *num_part_2way_ckk(const prob_set_t *ps, const ckk_params_t *params,
+                            ckk_stats_t *stats);
+
+#endif /* !DIFFERENCING_H */
@@ -0,0 +1,94 @@
+/** Times population fitness evaluation through the per-chromosome bit walk
+ * (the path number-partition.c used before fitness.h) against the batch
+ * kernels, and the 128-bit batch kernels used for FITNESS_WIDE instances
+ * @file fitness-bench.c */
+#include "chromosome.h"
+#include "fitness.h"
+#include "mono-clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+
+/** Number of item evaluations (population size * num_items * repetitions)
+ * timed per measurement */
+#define ITEMS_PER_RUN           (1 << 26)
+
+int main(void) {
+        static const size_t sizes[] = {10, 100, 1000};
+        rng_t rng;
+        rng_seed(&rng, 1);
+        printf("%6s %8s %14s %14s %9s %14s\n",
+               "N", "backend", "bit walk ns", "batch ns", "speedup",
+               "wide batch ns");
+        for (size_t s=0; s<sizeof(sizes)/sizeof(*sizes); s++) {
+                size_t num_items = sizes[s];
+                size_t pop_size = num_items;
+                size_t reps = ITEMS_PER_RUN / (num_items * pop_size) + 1;
+                long long *item_vals = malloc(sizeof(*item_vals) * num_items);
+                long long total = 0;
+                for (size_t i=0; i<num_items; i++) {
+                        /* bounded like the "rand" datasets */
+                        item_vals[i] = rng_below(&rng,
+                                                 LLONG_MAX / num_items);
+                        total += item_vals[i];
+                }
+                chrom_t **chroms = malloc(sizeof(*chroms) * pop_size);
+                const uint64_t **words = malloc(sizeof(*words) * pop_size);
+                for (size_t i=0; i<pop_size; i++) {
+                        chroms[i] = chrom_rand(num_items, &rng);
+                        words[i] = chroms[i]->words;
+                }
+                long long *walk_diffs = malloc(sizeof(long long) * pop_size);
+                long long *batch_diffs = malloc(sizeof(long long) * pop_size);
+                __int128 *wide_diffs = malloc(sizeof(__int128) * pop_size);
+                double t0, walk_ns, batch_ns, wide_ns;
+
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        for (size_t i=0; i<pop_size; i++) {
+                                walk_diffs[i] = fitness_diff(words[i],
+                                                             item_vals,
+                                                             num_items,
+                                                             total);
+                        }
+                }
+                walk_ns = (mono_now_ns() - t0) / reps;
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        fitness_diff_batch(words, pop_size, item_vals,
+                                           num_items, total, batch_diffs);
+                }
+                batch_ns = (mono_now_ns() - t0) / reps;
+                t0 = mono_now_ns();
+                for (size_t r=0; r<reps; r++) {
+                        fitness_diff_batch_wide(words, pop_size, item_vals,
+                                                num_items, total, wide_diffs);
+                }
+                wide_ns = (mono_now_ns() - t0) / reps;
+                for (size_t i=0; i<pop_size; i++) {
+                        if (walk_diffs[i] != batch_diffs[i]
+                            || walk_diffs[i] != wide_diffs[i]) {
+                                fprintf(stderr, "mismatch at N=%zu, "
+                                        "chromosome %zu: %lld != %lld\n",
+                                        num_items, i, walk_diffs[i],
+                                        batch_diffs[i]);
+                                return 1;
+                        }
+                }
+                printf("%6zu %8s %14.1f %14.1f %8.1fx %14.1f\n",
+                       num_items, fitness_backend(num_items), walk_ns,
+                       batch_ns, walk_ns / batch_ns, wide_ns);
+
+                for (size_t i=0; i<pop_size; i++) {
+                        chrom_free(chroms[i]);
+                }
+                free(chroms);
+                free(words);
+                free(walk_diffs);
+                free(batch_diffs);
+                free(wide_diffs);
+                free(item_vals);
+        }
+        return 0;
+}
+
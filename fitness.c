@@ -0,0 +1,360 @@
+/** Implements function prototypes in fitness.h
+ * @file fitness.c */
+#include "fitness.h"
+#include "chromosome.h"
+#include <limits.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86                1
+#else
+#define HAVE_X86                0
+#endif
+
+/** Defines NAME, returning the sum of the items in set1 of a chromosome by
+ * walking its set bits, accumulated in ACC_T; instantiated once per
+ * fitness_width_t */
+#define DEFINE_SET1_SUM(NAME, ACC_T)                                          \
+static ACC_T NAME(const uint64_t *words, const long long *item_vals,          \
+                  size_t num_items) {                                         \
+        size_t num_words = BITS2WORDS(num_items);                             \
+        ACC_T set1_sum = 0;                                                   \
+        for (size_t i=0; i<num_words; i++) {                                  \
+                uint64_t word = words[i];                                     \
+                const long long *word_vals = item_vals + i * WORD_BITS;       \
+                while (word != 0) {                                           \
+                        set1_sum += (ACC_T)word_vals[__builtin_ctzll(word)];  \
+                        word &= word - 1;                                     \
+                }                                                             \
+        }                                                                     \
+        return set1_sum;                                                      \
+}
+DEFINE_SET1_SUM(set1_sum_narrow, unsigned long long)
+DEFINE_SET1_SUM(set1_sum_wide, __int128)
+/** Returns the sum of the absolute values of the items, which bounds the
+ * unfitness of every chromosome */
+static unsigned __int128 abs_sum(const long long *item_vals,
+                                 size_t num_items) {
+        unsigned __int128 abs_total = 0;
+        for (size_t i=0; i<num_items; i++) {
+                long long val = item_vals[i];
+                abs_total += (val < 0) ? -(unsigned __int128)val
+                                       : (unsigned __int128)val;
+        }
+        return abs_total;
+}
+
+fitness_width_t fitness_width(const long long *item_vals, size_t num_items) {
+        return (abs_sum(item_vals, num_items) <= LLONG_MAX) ? FITNESS_NARROW
+                                                            : FITNESS_WIDE;
+}
+unsigned fitness_key_shift(const long long *item_vals, size_t num_items) {
+        unsigned __int128 abs_total = abs_sum(item_vals, num_items);
+        unsigned shift = 0;
+        /* the largest key must stay below LLONG_MAX, which the engines use
+         * as "none yet" */
+        while (abs_total > FITNESS_KEY_EXACT
+               && (abs_total - FITNESS_KEY_EXACT) >> shift
+                  >= FITNESS_KEY_EXACT - 1) {
+                shift++;
+        }
+        return shift;
+}
+long long fitness_key(unsigned __int128 unfitness, unsigned shift) {
+        if (unfitness < FITNESS_KEY_EXACT) {
+                return (long long)unfitness;
+        }
+        return FITNESS_KEY_EXACT
+               + (long long)((unfitness - FITNESS_KEY_EXACT) >> shift);
+}
+unsigned __int128 fitness_key_value(long long key, unsigned shift) {
+        if (key < FITNESS_KEY_EXACT) {
+                return (unsigned __int128)key;
+        }
+        return FITNESS_KEY_EXACT
+               + ((unsigned __int128)(key - FITNESS_KEY_EXACT) << shift);
+}
+__int128 fitness_sum(const long long *item_vals, size_t num_items) {
+        __int128 total = 0;
+        for (size_t i=0; i<num_items; i++) {
+                total += item_vals[i];
+        }
+        return total;
+}
+/* The narrow kernels accumulate the set1 sum unsigned and return
+ * total - 2*sum; the intermediate 2*sum may wrap but the final difference is
+ * exact whenever it fits in a long long */
+long long fitness_diff(const uint64_t *words, const long long *item_vals,
+                       size_t num_items, long long total) {
+        unsigned long long set1_sum = set1_sum_narrow(words, item_vals,
+                                                      num_items);
+        return (long long)((unsigned long long)total - 2 * set1_sum);
+}
+__int128 fitness_diff_wide(const uint64_t *words, const long long *item_vals,
+                           size_t num_items, __int128 total) {
+        return total - 2 * set1_sum_wide(words, item_vals, num_items);
+}
+long long fitness_diff_from(const uint64_t *words, const uint64_t *base,
+                            long long base_diff, bool base_inverted,
+                            const long long *item_vals, size_t num_items) {
+        size_t num_words = BITS2WORDS(num_items);
+        uint64_t invert = base_inverted ? ~(uint64_t)0 : 0;
+        unsigned long long diff = (unsigned long long)base_diff;
+        if (base_inverted) {
+                diff = -diff;
+        }
+        for (size_t i=0; i<num_words; i++) {
+                uint64_t changed = words[i] ^ base[i] ^ invert;
+                if (i == num_words - 1) {
+                        changed &= TAIL_MASK(num_items);
+                }
+                const long long *word_vals = item_vals + i * WORD_BITS;
+                while (changed != 0) {
+                        int bit = __builtin_ctzll(changed);
+                        unsigned long long twice = 2 * (unsigned long long)
+                                                   word_vals[bit];
+                        /* all ones if the item joined set1, negating twice;
+                         * branchless since either way is equally likely */
+                        unsigned long long joined = -((words[i] >> bit) & 1);
+                        diff += (twice ^ joined) - joined;
+                        changed &= changed - 1;
+                }
+        }
+        return (long long)diff;
+}
+void fitness_diff_batch(const uint64_t *const *chroms, size_t num_chroms,
+                        const long long *item_vals, size_t num_items,
+                        long long total, long long *diffs) {
+        if (num_items >= FITNESS_VECTOR_MIN && fitness_has_avx2()) {
+                fitness_diff_batch_avx2(chroms, num_chroms, item_vals,
+                                        num_items, total, diffs);
+        } else {
+                fitness_diff_batch_scalar(chroms, num_chroms, item_vals,
+                                          num_items, total, diffs);
+        }
+}
+void fitness_diff_batch_wide(const uint64_t *const *chroms,
+                             size_t num_chroms, const long long *item_vals,
+                             size_t num_items, __int128 total,
+                             __int128 *diffs) {
+        if (num_items >= FITNESS_VECTOR_MIN && fitness_has_avx2()) {
+                fitness_diff_batch_wide_avx2(chroms, num_chroms, item_vals,
+                                             num_items, total, diffs);
+        } else {
+                fitness_diff_batch_wide_scalar(chroms, num_chroms, item_vals,
+                                               num_items, total, diffs);
+        }
+}
+const char *fitness_backend(size_t num_items) {
+        return (num_items >= FITNESS_VECTOR_MIN && fitness_has_avx2())
+               ? "avx2"
+               : "scalar";
+}
+
+/* LOW-LEVEL API */
+/* Walking the set bits beats a branchless masked sum in scalar code, so the
+ * portable kernel is the single chromosome walk */
+void fitness_diff_batch_scalar(const uint64_t *const *chroms,
+                               size_t num_chroms,
+                               const long long *item_vals, size_t num_items,
+                               long long total, long long *diffs) {
+        for (size_t i=0; i<num_chroms; i++) {
+                diffs[i] = fitness_diff(chroms[i], item_vals, num_items,
+                                        total);
+        }
+}
+void fitness_diff_batch_wide_scalar(const uint64_t *const *chroms,
+                                    size_t num_chroms,
+                                    const long long *item_vals,
+                                    size_t num_items, __int128 total,
+                                    __int128 *diffs) {
+        for (size_t i=0; i<num_chroms; i++) {
+                diffs[i] = fitness_diff_wide(chroms[i], item_vals, num_items,
+                                             total);
+        }
+}
+
+#if HAVE_X86
+bool fitness_has_avx2(void) {
+        return __builtin_cpu_supports("avx2");
+}
+/** AVX2 kernel for exactly FITNESS_GROUP chromosomes; 4 item values are
+ * loaded per step and masked by each chromosome's matching 4 bits. Lane k
+ * shifts its copy of the word so that bit j+k sits in the sign position,
+ * which turns the mask into a single compare */
+__attribute__((target("avx2")))
+static void group_avx2(const uint64_t *const *chroms,
+                       const long long *item_vals, size_t num_items,
+                       long long total, long long *diffs) {
+        const __m256i first_shifts = _mm256_set_epi64x(60, 61, 62, 63);
+        const __m256i step = _mm256_set1_epi64x(4);
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i acc[FITNESS_GROUP];
+        unsigned long long tail_sums[FITNESS_GROUP] = {0};
+        for (size_t c=0; c<FITNESS_GROUP; c++) {
+                acc[c] = zero;
+        }
+        for (size_t w=0; w<BITS2WORDS(num_items); w++) {
+                __m256i words[FITNESS_GROUP];
+#pragma GCC unroll 4
+                for (size_t c=0; c<FITNESS_GROUP; c++) {
+                        words[c] = _mm256_set1_epi64x(chroms[c][w]);
+                }
+                __m256i shifts = first_shifts;
+                const long long *word_vals = item_vals + w * WORD_BITS;
+                size_t word_items = (num_items - w * WORD_BITS < WORD_BITS)
+                                    ? num_items - w * WORD_BITS
+                                    : WORD_BITS;
+                size_t j = 0;
+                for (; j + 4 <= word_items; j+=4) {
+                        __m256i vals = _mm256_loadu_si256(
+                                        (const __m256i *)(word_vals + j));
+                        /* unrolled so that the group stays in registers */
+#pragma GCC unroll 4
+                        for (size_t c=0; c<FITNESS_GROUP; c++) {
+                                __m256i mask = _mm256_cmpgt_epi64(zero,
+                                                _mm256_sllv_epi64(words[c],
+                                                                  shifts));
+                                acc[c] = _mm256_add_epi64(acc[c],
+                                                _mm256_and_si256(vals, mask));
+                        }
+                        shifts = _mm256_sub_epi64(shifts, step);
+                }
+                for (; j<word_items; j++) {
+                        for (size_t c=0; c<FITNESS_GROUP; c++) {
+                                uint64_t bit = (chroms[c][w] >> j) & 1;
+                                tail_sums[c] += (unsigned long long)
+                                                word_vals[j] & -bit;
+                        }
+                }
+        }
+        for (size_t c=0; c<FITNESS_GROUP; c++) {
+                unsigned long long lanes[4];
+                _mm256_storeu_si256((__m256i *)lanes, acc[c]);
+                unsigned long long set1_sum = lanes[0] + lanes[1] + lanes[2]
+                                              + lanes[3] + tail_sums[c];
+                diffs[c] = (long long)((unsigned long long)total
+                                       - 2 * set1_sum);
+        }
+}
+void fitness_diff_batch_avx2(const uint64_t *const *chroms, size_t num_chroms,
+                             const long long *item_vals, size_t num_items,
+                             long long total, long long *diffs) {
+        size_t i = 0;
+        for (; i + FITNESS_GROUP <= num_chroms; i+=FITNESS_GROUP) {
+                group_avx2(chroms + i, item_vals, num_items, total,
+                           diffs + i);
+        }
+        fitness_diff_batch_scalar(chroms + i, num_chroms - i, item_vals,
+                                  num_items, total, diffs + i);
+}
+/** Wide counterpart of group_avx2; each item value is split into its low and
+ * high 32-bit halves, summed in separate 64-bit lanes that cannot overflow
+ * for fewer than 2^34 items. The high half is taken unsigned, which
+ * overstates a negative value by 2^64, so the selected negative values are
+ * counted to take that back out */
+__attribute__((target("avx2")))
+static void group_wide_avx2(const uint64_t *const *chroms,
+                            const long long *item_vals, size_t num_items,
+                            __int128 total, __int128 *diffs) {
+        const __m256i first_shifts = _mm256_set_epi64x(60, 61, 62, 63);
+        const __m256i step = _mm256_set1_epi64x(4);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i low_mask = _mm256_set1_epi64x(0xffffffff);
+        __m256i lo_acc[FITNESS_GROUP];
+        __m256i hi_acc[FITNESS_GROUP];
+        __m256i neg_acc[FITNESS_GROUP];
+        __int128 tail_sums[FITNESS_GROUP] = {0};
+        for (size_t c=0; c<FITNESS_GROUP; c++) {
+                lo_acc[c] = zero;
+                hi_acc[c] = zero;
+                neg_acc[c] = zero;
+        }
+        for (size_t w=0; w<BITS2WORDS(num_items); w++) {
+                __m256i words[FITNESS_GROUP];
+#pragma GCC unroll 4
+                for (size_t c=0; c<FITNESS_GROUP; c++) {
+                        words[c] = _mm256_set1_epi64x(chroms[c][w]);
+                }
+                __m256i shifts = first_shifts;
+                const long long *word_vals = item_vals + w * WORD_BITS;
+                size_t word_items = (num_items - w * WORD_BITS < WORD_BITS)
+                                    ? num_items - w * WORD_BITS
+                                    : WORD_BITS;
+                size_t j = 0;
+                for (; j + 4 <= word_items; j+=4) {
+                        __m256i vals = _mm256_loadu_si256(
+                                        (const __m256i *)(word_vals + j));
+                        __m256i lo = _mm256_and_si256(vals, low_mask);
+                        __m256i hi = _mm256_srli_epi64(vals, 32);
+                        __m256i neg = _mm256_cmpgt_epi64(zero, vals);
+#pragma GCC unroll 4
+                        for (size_t c=0; c<FITNESS_GROUP; c++) {
+                                __m256i mask = _mm256_cmpgt_epi64(zero,
+                                                _mm256_sllv_epi64(words[c],
+                                                                  shifts));
+                                lo_acc[c] = _mm256_add_epi64(lo_acc[c],
+                                                _mm256_and_si256(lo, mask));
+                                hi_acc[c] = _mm256_add_epi64(hi_acc[c],
+                                                _mm256_and_si256(hi, mask));
+                                /* adds -1 per selected negative value */
+                                neg_acc[c] = _mm256_add_epi64(neg_acc[c],
+                                                _mm256_and_si256(neg, mask));
+                        }
+                        shifts = _mm256_sub_epi64(shifts, step);
+                }
+                for (; j<word_items; j++) {
+                        for (size_t c=0; c<FITNESS_GROUP; c++) {
+                                if ((chroms[c][w] >> j) & 1) {
+                                        tail_sums[c] += word_vals[j];
+                                }
+                        }
+                }
+        }
+        for (size_t c=0; c<FITNESS_GROUP; c++) {
+                long long lo[4], hi[4], neg[4];
+                _mm256_storeu_si256((__m256i *)lo, lo_acc[c]);
+                _mm256_storeu_si256((__m256i *)hi, hi_acc[c]);
+                _mm256_storeu_si256((__m256i *)neg, neg_acc[c]);
+                __int128 set1_sum = tail_sums[c];
+                for (size_t k=0; k<4; k++) {
+                        set1_sum += (__int128)lo[k]
+                                    + ((__int128)hi[k] << 32)
+                                    + ((__int128)neg[k] << 64);
+                }
+                diffs[c] = total - 2 * set1_sum;
+        }
+}
+void fitness_diff_batch_wide_avx2(const uint64_t *const *chroms,
+                                  size_t num_chroms,
+                                  const long long *item_vals,
+                                  size_t num_items, __int128 total,
+                                  __int128 *diffs) {
+        size_t i = 0;
+        for (; i + FITNESS_GROUP <= num_chroms; i+=FITNESS_GROUP) {
+                group_wide_avx2(chroms + i, item_vals, num_items, total,
+                                diffs + i);
+        }
+        fitness_diff_batch_wide_scalar(chroms + i, num_chroms - i, item_vals,
+                                       num_items, total, diffs + i);
+}
+#else
+bool fitness_has_avx2(void) {
+        return false;
+}
+void fitness_diff_batch_avx2(const uint64_t *const *chroms, size_t num_chroms,
+                             const long long *item_vals, size_t num_items,
+                             long long total, long long *diffs) {
+        fitness_diff_batch_scalar(chroms, num_chroms, item_vals, num_items,
+                                  total, diffs);
+}
+void fitness_diff_batch_wide_avx2(const uint64_t *const *chroms,
+                                  size_t num_chroms,
+                                  const long long *item_vals,
+                                  size_t num_items, __int128 total,
+                                  __int128 *diffs) {
+        fitness_diff_batch_wide_scalar(chroms, num_chroms, item_vals,
+                                       num_items, total, diffs);
+}
+#endif
+/* LOW-LEVEL API */
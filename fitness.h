@@ -0,0 +1,113 @@
+#ifndef FITNESS_H
+#define FITNESS_H
+/** Evaluates the signed subset-sum difference of chromosomes against a shared
+ * array of item values
+ * @file fitness.h */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Number of chromosomes evaluated together by the batch kernels; each block
+ * of item values is loaded once per group of this many chromosomes */
+#define FITNESS_GROUP           4
+/** Fewest items for which the vector kernel beats walking the set bits */
+#define FITNESS_VECTOR_MIN      32
+/** Unfitness below which fitness_key is exact for every instance */
+#define FITNESS_KEY_EXACT       ((long long)1 << 62)
+
+typedef enum fitness_width fitness_width_t;
+/** Accumulator width an instance must be evaluated with to stay exact */
+enum fitness_width {
+        /** Every difference fits in a long long; the 64-bit kernels apply */
+        FITNESS_NARROW,
+        /** Some differences may not; sums are accumulated in __int128 */
+        FITNESS_WIDE
+};
+
+/** Returns the narrowest accumulator width that evaluates every chromosome
+ * of an instance exactly; an O(num_items) check meant to run once at load
+ * time. Differences are bounded by the sum of absolute item values, so the
+ * instance is narrow whenever that sum fits in a long long */
+fitness_width_t fitness_width(const long long *item_vals, size_t num_items);
+/** Returns the right shift fitness_key needs for no unfitness of an
+ * instance to reach LLONG_MAX: 0 for FITNESS_NARROW instances, and a few
+ * bits for FITNESS_WIDE ones */
+unsigned fitness_key_shift(const long long *item_vals, size_t num_items);
+/** Returns the long long key the engines rank a chromosome by: unfitness
+ * itself below FITNESS_KEY_EXACT, and FITNESS_KEY_EXACT plus the excess
+ * shifted right by shift above it. Keys never reverse the order of two
+ * unfitness values, and with a shift of 0 every key is exact */
+long long fitness_key(unsigned __int128 unfitness, unsigned shift);
+/** Returns the smallest unfitness with the given key */
+unsigned __int128 fitness_key_value(long long key, unsigned shift);
+/** Returns the exact sum of all item values */
+__int128 fitness_sum(const long long *item_vals, size_t num_items);
+
+/** Returns the signed difference (sum of set0 - sum of set1) of a single
+ * chromosome in the chromosome word layout; total is the sum of all item
+ * values
+ * @pre                 the true difference fits in a long long */
+long long fitness_diff(const uint64_t *words, const long long *item_vals,
+                       size_t num_items, long long total);
+/** Returns the exact signed difference of a single chromosome of any
+ * instance, accumulating in __int128; total is the sum of all item values */
+__int128 fitness_diff_wide(const uint64_t *words, const long long *item_vals,
+                           size_t num_items, __int128 total);
+/** Returns the signed difference of a chromosome given the difference
+ * base_diff of a related chromosome base, in O(bits that differ); each bit
+ * that moved an item into set1 subtracts twice its value and each bit that
+ * moved it into set0 adds twice its value. If base_inverted is set, the
+ * chromosome is instead compared to the inverse of base, whose difference is
+ * -base_diff
+ * @pre                 the true difference fits in a long long */
+long long fitness_diff_from(const uint64_t *words, const uint64_t *base,
+                            long long base_diff, bool base_inverted,
+                            const long long *item_vals, size_t num_items);
+/** Computes the signed difference of num_chroms chromosomes, writing the
+ * difference of chroms[i] into diffs[i]; dispatches to the AVX2 kernel when
+ * the CPU supports it and there are at least FITNESS_VECTOR_MIN items, and to
+ * the scalar kernel otherwise
+ * @pre                 the true differences fit in a long long */
+void fitness_diff_batch(const uint64_t *const *chroms, size_t num_chroms,
+                        const long long *item_vals, size_t num_items,
+                        long long total, long long *diffs);
+/** Same as fitness_diff_batch for instances of any width, accumulating in
+ * __int128 */
+void fitness_diff_batch_wide(const uint64_t *const *chroms,
+                             size_t num_chroms, const long long *item_vals,
+                             size_t num_items, __int128 total,
+                             __int128 *diffs);
+/** Returns the name of the kernel fitness_diff_batch dispatches to for
+ * num_items items */
+const char *fitness_backend(size_t num_items);
+
+/* LOW-LEVEL API */
+/** Portable batch kernel */
+void fitness_diff_batch_scalar(const uint64_t *const *chroms,
+                               size_t num_chroms,
+                               const long long *item_vals, size_t num_items,
+                               long long total, long long *diffs);
+/** Portable wide batch kernel */
+void fitness_diff_batch_wide_scalar(const uint64_t *const *chroms,
+                                    size_t num_chroms,
+                                    const long long *item_vals,
+                                    size_t num_items, __int128 total,
+                                    __int128 *diffs);
+/** Returns whether the AVX2 kernel can run on this CPU */
+bool fitness_has_avx2(void);
+/** AVX2 batch kernel
+ * @pre                 fitness_has_avx2() */
+void fitness_diff_batch_avx2(const uint64_t *const *chroms, size_t num_chroms,
+                             const long long *item_vals, size_t num_items,
+                             long long total, long long *diffs);
+/** AVX2 wide batch kernel
+ * @pre                 fitness_has_avx2() */
+void fitness_diff_batch_wide_avx2(const uint64_t *const *chroms,
+                                  size_t num_chroms,
+                                  const long long *item_vals,
+                                  size_t num_items, __int128 total,
+                                  __int128 *diffs);
+/* LOW-LEVEL API */
+
+#endif /* !FITNESS_H */
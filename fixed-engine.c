@@ -0,0 +1,422 @@
+/** Implements the fixed-width engines declared in ga-engine.h: the
+ * single-population engine of number-partition.c specialized at compile time
+ * for chromosomes of 1, 2, 4 and 16 words. Each chromosome is an inline
+ * array of a constant number of words, so that the crossover, inversion,
+ * distance and incremental evaluation loops are unrolled, and the
+ * populations and the mating pool live on the stack rather than on the
+ * heap. Offspring evaluated from scratch still go through
+ * fitness_diff_batch in groups, whose vector kernel beats an unrolled scalar
+ * one at every width.
+ *
+ * The engines draw the same random numbers in the same order as the general
+ * engine and evaluate every offspring exactly, so a run returns the same
+ * partition through either.
+ * @file fixed-engine.c */
+#include "ga-engine.h"
+#include <string.h>
+#include <limits.h>
+
+/** Forces a function taking its width as a parameter to be inlined into
+ * each instance, where the width is a constant */
+#define FIXED_INLINE            static inline __attribute__((always_inline))
+
+/** Population of a fixed-width run */
+struct fixed_pop {
+        /** Chromosome i is words [i * width, (i + 1) * width) */
+        uint64_t *words;
+        long long *unfitness;
+        /** Signed differences, for incremental evaluation */
+        long long *diff;
+};
+/** Fixed-width engine for instances of at most max_bits items */
+struct fixed_engine {
+        size_t max_bits;
+        result_t *(*run)(const prob_set_t *ps, const ga_params_t *params,
+                         const ga_ctx_t *ctx);
+};
+
+/** Writes into mask, for each of the width words of a chromosome of
+ * num_bits bits, the bits that belong to it */
+FIXED_INLINE void fixed_mask(uint64_t *mask, size_t width, size_t num_bits);
+/** Inverts a chromosome if its leading bit is 1 */
+FIXED_INLINE void fixed_normalize(uint64_t *chrom, const uint64_t *mask,
+                                  size_t width);
+/** Fills a chromosome with random bits, drawing num_words words as
+ * words_rand does */
+FIXED_INLINE void fixed_rand(uint64_t *chrom, const uint64_t *mask,
+                             size_t width, size_t num_words, rng_t *rng);
+/** Uniform crossover drawing num_words mask words, as words_ucx does */
+FIXED_INLINE void fixed_ucx(uint64_t *child, const uint64_t *parent1,
+                            const uint64_t *parent2, size_t width,
+                            size_t num_words, rng_t *rng);
+/** Writes into child the bits [lo, hi) of parent2 and the other bits of
+ * parent1 */
+FIXED_INLINE void fixed_range_cx(uint64_t *child, const uint64_t *parent1,
+                                 const uint64_t *parent2, size_t width,
+                                 size_t lo, size_t hi);
+/** Evaluates child from whichever of its parents, or their inverses, it is
+ * closest to, as new_gen does; returns false without evaluating if even the
+ * closest differs in more than num_bits / DELTA_FITNESS_DIV bits */
+FIXED_INLINE bool fixed_diff_from_parents(const uint64_t *child,
+                                          const uint64_t *parent1,
+                                          long long diff1,
+                                          const uint64_t *parent2,
+                                          long long diff2,
+                                          const uint64_t *mask,
+                                          const long long *vals,
+                                          size_t width, size_t num_bits,
+                                          long long *diff);
+/** Evaluates the chromosomes of pop listed in indices from scratch with
+ * fitness_diff_batch */
+static void fixed_eval_group(struct fixed_pop *pop, const size_t *indices,
+                             size_t group_size, const long long *vals,
+                             size_t width, size_t num_bits, long long total);
+/** Returns the index of the fittest chromosome of the population */
+static size_t fixed_fittest(const long long *unfitness, size_t pop_size);
+/** Runs the engine with chromosomes of width words, using the stack
+ * buffers of its instance
+ * @pre                 ps->num_items <= width * WORD_BITS and
+ *                      ctx->pop_size <= FIXED_MAX_POP */
+FIXED_INLINE result_t *fixed_run(const prob_set_t *ps,
+                                 const ga_params_t *params,
+                                 const ga_ctx_t *ctx, size_t width,
+                                 struct fixed_pop pops[2], size_t *pool);
+
+/** Defines NAME, running the engine with chromosomes of WIDTH words; its
+ * populations take 2 * FIXED_MAX_POP * (WIDTH + 2) words of stack */
+#define DEFINE_FIXED_ENGINE(NAME, WIDTH)                                      \
+static result_t *NAME(const prob_set_t *ps, const ga_params_t *params,        \
+                      const ga_ctx_t *ctx) {                                  \
+        uint64_t words[2][FIXED_MAX_POP * (WIDTH)];                           \
+        long long unfitness[2][FIXED_MAX_POP];                                \
+        long long diff[2][FIXED_MAX_POP];                                     \
+        size_t pool[FIXED_MAX_POP];                                           \
+        struct fixed_pop pops[2] = {{words[0], unfitness[0], diff[0]},        \
+                                    {words[1], unfitness[1], diff[1]}};       \
+        return fixed_run(ps, params, ctx, (WIDTH), pops, pool);               \
+}
+DEFINE_FIXED_ENGINE(run_fixed_64, 1)
+DEFINE_FIXED_ENGINE(run_fixed_128, 2)
+DEFINE_FIXED_ENGINE(run_fixed_256, 4)
+DEFINE_FIXED_ENGINE(run_fixed_1024, 16)
+
+static const struct fixed_engine fixed_engines[] = {
+        {64, run_fixed_64},
+        {128, run_fixed_128},
+        {256, run_fixed_256},
+        {1024, run_fixed_1024}
+};
+
+result_t *num_part_2way_fixed(const prob_set_t *ps,
+                              const ga_params_t *params,
+                              const ga_ctx_t *ctx, ga_stats_t *stats) {
+        /* the engines run one population on the calling thread and leave
+         * out the stages that allocate */
+        if (!params->fixed_width || params->num_threads > 1
+            || params->num_islands > 1 || params->trace != NULL
+            || ctx->ls_top_k > 0 || ctx->width != FITNESS_NARROW
+            || ctx->pop_size > FIXED_MAX_POP || ps->num_items == 0) {
+                return NULL;
+        }
+        for (size_t e=0; e<sizeof(fixed_engines)/sizeof(*fixed_engines);
+             e++) {
+                if (ps->num_items <= fixed_engines[e].max_bits) {
+                        if (stats != NULL) {
+                                *stats = (ga_stats_t){0};
+                        }
+                        return fixed_engines[e].run(ps, params, ctx);
+                }
+        }
+        return NULL;
+}
+
+FIXED_INLINE void fixed_mask(uint64_t *mask, size_t width, size_t num_bits) {
+        size_t num_words = BITS2WORDS(num_bits);
+        for (size_t k=0; k<width; k++) {
+                mask[k] = (k + 1 < num_words) ? ~(uint64_t)0
+                          : (k + 1 == num_words) ? TAIL_MASK(num_bits)
+                          : 0;
+        }
+}
+FIXED_INLINE void fixed_normalize(uint64_t *chrom, const uint64_t *mask,
+                                  size_t width) {
+        if (chrom[0] & INITIAL_BIT) {
+                for (size_t k=0; k<width; k++) {
+                        chrom[k] = ~chrom[k] & mask[k];
+                }
+        }
+}
+FIXED_INLINE void fixed_rand(uint64_t *chrom, const uint64_t *mask,
+                             size_t width, size_t num_words, rng_t *rng) {
+        rng_fill(rng, chrom, num_words);
+        for (size_t k=0; k<width; k++) {
+                chrom[k] = (k < num_words) ? chrom[k] & mask[k] : 0;
+        }
+}
+FIXED_INLINE void fixed_ucx(uint64_t *child, const uint64_t *parent1,
+                            const uint64_t *parent2, size_t width,
+                            size_t num_words, rng_t *rng) {
+        uint64_t masks[width];
+        rng_fill(rng, masks, num_words);
+        /* the parents' padding words are 0, and so the child's */
+        for (size_t k=0; k<width; k++) {
+                child[k] = (k < num_words)
+                           ? (parent1[k] & masks[k])
+                             | (parent2[k] & ~masks[k])
+                           : 0;
+        }
+}
+FIXED_INLINE void fixed_range_cx(uint64_t *child, const uint64_t *parent1,
+                                 const uint64_t *parent2, size_t width,
+                                 size_t lo, size_t hi) {
+        for (size_t k=0; k<width; k++) {
+                size_t word_lo = k * WORD_BITS;
+                size_t word_hi = word_lo + WORD_BITS;
+                uint64_t mask = 0;
+                if (lo < word_hi && hi > word_lo) {
+                        size_t from = (lo > word_lo) ? lo - word_lo : 0;
+                        size_t to = (hi < word_hi) ? hi - word_lo : WORD_BITS;
+                        mask = (to - from == WORD_BITS)
+                               ? ~(uint64_t)0
+                               : (((uint64_t)1 << (to - from)) - 1) << from;
+                }
+                child[k] = (parent1[k] & ~mask) | (parent2[k] & mask);
+        }
+}
+FIXED_INLINE bool fixed_diff_from_parents(const uint64_t *child,
+                                          const uint64_t *parent1,
+                                          long long diff1,
+                                          const uint64_t *parent2,
+                                          long long diff2,
+                                          const uint64_t *mask,
+                                          const long long *vals,
+                                          size_t width, size_t num_bits,
+                                          long long *diff) {
+        size_t dist1 = 0;
+        size_t dist2 = 0;
+        for (size_t k=0; k<width; k++) {
+                dist1 += __builtin_popcountll(child[k] ^ parent1[k]);
+                dist2 += __builtin_popcountll(child[k] ^ parent2[k]);
+        }
+        /* the same order of preference as child_diff_from_parents */
+        const uint64_t *base = parent1;
+        long long base_diff = diff1;
+        bool base_inverted = false;
+        size_t min_dist = dist1;
+        if (num_bits - dist1 < min_dist) {
+                min_dist = num_bits - dist1;
+                base_inverted = true;
+        }
+        if (dist2 < min_dist) {
+                min_dist = dist2;
+                base = parent2;
+                base_diff = diff2;
+                base_inverted = false;
+        }
+        if (num_bits - dist2 < min_dist) {
+                min_dist = num_bits - dist2;
+                base = parent2;
+                base_diff = diff2;
+                base_inverted = true;
+        }
+        if (min_dist > num_bits / DELTA_FITNESS_DIV) {
+                return false;
+        }
+        uint64_t invert = base_inverted ? ~(uint64_t)0 : 0;
+        unsigned long long sum = (unsigned long long)base_diff;
+        if (base_inverted) {
+                sum = -sum;
+        }
+        for (size_t k=0; k<width; k++) {
+                uint64_t changed = (child[k] ^ base[k] ^ invert) & mask[k];
+                while (changed != 0) {
+                        int bit = __builtin_ctzll(changed);
+                        unsigned long long twice = 2 * (unsigned long long)
+                                                   vals[k * WORD_BITS + bit];
+                        unsigned long long joined = -((child[k] >> bit) & 1);
+                        sum += (twice ^ joined) - joined;
+                        changed &= changed - 1;
+                }
+        }
+        *diff = (long long)sum;
+        return true;
+}
+static void fixed_eval_group(struct fixed_pop *pop, const size_t *indices,
+                             size_t group_size, const long long *vals,
+                             size_t width, size_t num_bits, long long total) {
+        const uint64_t *group[FITNESS_GROUP] = {NULL};
+        for (size_t c=0; c<group_size; c++) {
+                group[c] = pop->words + indices[c] * width;
+        }
+        long long diffs[FITNESS_GROUP];
+        fitness_diff_batch(group, group_size, vals, num_bits, total, diffs);
+        for (size_t c=0; c<group_size; c++) {
+                pop->diff[indices[c]] = diffs[c];
+                pop->unfitness[indices[c]] = (diffs[c] < 0) ? -diffs[c]
+                                                            : diffs[c];
+        }
+}
+static size_t fixed_fittest(const long long *unfitness, size_t pop_size) {
+        size_t fittest_i = 0;
+        for (size_t i=1; i<pop_size; i++) {
+                if (unfitness[i] < unfitness[fittest_i]) {
+                        fittest_i = i;
+                }
+        }
+        return fittest_i;
+}
+FIXED_INLINE result_t *fixed_run(const prob_set_t *ps,
+                                 const ga_params_t *params,
+                                 const ga_ctx_t *ctx, size_t width,
+                                 struct fixed_pop pops[2], size_t *pool) {
+        const size_t num_bits = ps->num_items;
+        const size_t num_words = BITS2WORDS(num_bits);
+        const size_t pop_size = ctx->pop_size;
+        const long long *vals = ps->item_vals;
+        const long long total = (long long)ctx->total;
+        uint64_t mask[width];
+        fixed_mask(mask, width, num_bits);
+        /* the same stream as thread 0 of the general engine */
+        rng_t rng;
+        rng_seed_stream(&rng, params->seed, params->stream);
+        size_t cur = 0;
+        size_t num_seeds = (size_t)(ctx->seed_fraction * pop_size + 0.5);
+        for (size_t i=0; i<pop_size; i++) {
+                uint64_t *chrom = pops[cur].words + i * width;
+                if (i < num_seeds) {
+                        for (size_t k=0; k<width; k++) {
+                                chrom[k] = 0;
+                        }
+                        seed_chrom(chrom, i, ctx, &rng);
+                } else {
+                        fixed_rand(chrom, mask, width, num_words, &rng);
+                        fixed_normalize(chrom, mask, width);
+                }
+        }
+        for (size_t i=0; i<pop_size; i+=FITNESS_GROUP) {
+                size_t group_size = (pop_size - i < FITNESS_GROUP)
+                                    ? pop_size - i
+                                    : FITNESS_GROUP;
+                size_t indices[FITNESS_GROUP];
+                for (size_t c=0; c<group_size; c++) {
+                        indices[c] = i + c;
+                }
+                fixed_eval_group(pops + cur, indices, group_size, vals,
+                                 width, num_bits, total);
+        }
+        uint64_t best[width];
+        size_t fittest_i = fixed_fittest(pops[cur].unfitness, pop_size);
+        long long best_unfitness = pops[cur].unfitness[fittest_i];
+        memcpy(best, pops[cur].words + fittest_i * width, sizeof(best));
+        size_t num_gens_passed = 1;
+        size_t stall_gens = 0;
+        bool past_deadline = false;
+        while (!ga_converged(ctx, num_gens_passed, best_unfitness,
+                             stall_gens)
+               && !past_deadline) {
+                const struct fixed_pop *pop = pops + cur;
+                struct fixed_pop *next = pops + !cur;
+                /* as in new_gen, offspring too far from their parents are
+                 * evaluated together once a full group has been collected,
+                 * and probing for close parents stops for the rest of a
+                 * generation after enough misses in a row */
+                size_t pending[FITNESS_GROUP];
+                size_t num_pending = 0;
+                size_t num_misses = 0;
+                for (size_t i=0; i<pop_size; i++) {
+                        size_t winner = rng_below(&rng, pop_size);
+                        for (size_t k=1; k<ctx->tourn_size; k++) {
+                                size_t other = rng_below(&rng, pop_size);
+                                if (pop->unfitness[winner]
+                                    > pop->unfitness[other]) {
+                                        winner = other;
+                                }
+                        }
+                        pool[i] = winner;
+                }
+                for (size_t i=0; i<pop_size; i++) {
+                        size_t p1i = pool[rng_below(&rng, pop_size)];
+                        size_t p2i = pool[rng_below(&rng, pop_size)];
+                        const uint64_t *p1 = pop->words + p1i * width;
+                        const uint64_t *p2 = pop->words + p2i * width;
+                        uint64_t *child = next->words + i * width;
+                        size_t cut1, cut2;
+                        switch (ctx->crossover) {
+                        case CROSSOVER_ONE_POINT:
+                                cut1 = rng_below(&rng, num_bits + 1);
+                                fixed_range_cx(child, p1, p2, width, cut1,
+                                               num_bits);
+                                break;
+                        case CROSSOVER_TWO_POINT:
+                                cut1 = rng_below(&rng, num_bits + 1);
+                                cut2 = rng_below(&rng, num_bits + 1);
+                                if (cut1 > cut2) {
+                                        size_t tmp = cut1;
+                                        cut1 = cut2;
+                                        cut2 = tmp;
+                                }
+                                fixed_range_cx(child, p1, p2, width, cut1,
+                                               cut2);
+                                break;
+                        default:
+                                fixed_ucx(child, p1, p2, width, num_words,
+                                          &rng);
+                                break;
+                        }
+                        fixed_normalize(child, mask, width);
+                        words_mutate(child, num_bits, ctx->mutation_rate,
+                                     &rng);
+                        fixed_normalize(child, mask, width);
+                        long long diff;
+                        bool try_delta = ctx->delta_fitness
+                                         && num_misses < DELTA_FITNESS_PROBES;
+                        if (try_delta
+                            && !fixed_diff_from_parents(child, p1,
+                                                        pop->diff[p1i], p2,
+                                                        pop->diff[p2i], mask,
+                                                        vals, width,
+                                                        num_bits, &diff)) {
+                                num_misses++;
+                                try_delta = false;
+                        }
+                        if (try_delta) {
+                                num_misses = 0;
+                                next->diff[i] = diff;
+                                next->unfitness[i] = (diff < 0) ? -diff
+                                                                : diff;
+                        } else {
+                                pending[num_pending++] = i;
+                                if (num_pending == FITNESS_GROUP) {
+                                        fixed_eval_group(next, pending,
+                                                         num_pending, vals,
+                                                         width, num_bits,
+                                                         total);
+                                        num_pending = 0;
+                                }
+                        }
+                }
+                fixed_eval_group(next, pending, num_pending, vals, width,
+                                 num_bits, total);
+                fittest_i = fixed_fittest(next->unfitness, pop_size);
+                past_deadline = ga_past_deadline(ctx);
+                cur = !cur;
+                if (next->unfitness[fittest_i] < best_unfitness) {
+                        best_unfitness = next->unfitness[fittest_i];
+                        memcpy(best, next->words + fittest_i * width,
+                               sizeof(best));
+                        stall_gens = 0;
+                } else {
+                        stall_gens++;
+                }
+                num_gens_passed++;
+        }
+        /* the result is the only allocation of the run besides those of
+         * the heuristic seeds */
+        chrom_t *best_chrom = chrom_malloc(num_bits);
+        memcpy(best_chrom->words, best, sizeof(uint64_t) * num_words);
+        best_chrom->unfitness = best_unfitness;
+        result_t *res = result_malloc(best_chrom, ps->item_vals,
+                                      num_gens_passed);
+        chrom_free(best_chrom);
+        return res;
+}
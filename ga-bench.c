@@ -0,0 +1,65 @@
+/** Measures generation throughput of num_part_2way_params for increasing
+ * thread counts and checks that repeated runs with the same seed and thread
+ * count agree
+ * @file ga-bench.c */
+#include "number-partition.h"
+#include "chromosome.h"
+#include "prob-io.h"
+#include "mono-clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Number of runs timed per thread count */
+#define NUM_RUNS                3
+
+/** Returns whether two results describe the same partition */
+static int result_eq(const result_t *r1, const result_t *r2);
+
+/* Usage: ga-bench.out [max_threads] < input
+ * Thread counts double from 1 up to max_threads (default 32); input format
+ * is the same as genetic-algorithm.out's */
+int main(int argc, char **argv) {
+        size_t max_threads = (argc > 1) ? strtoul(argv[1], NULL, 0) : 32;
+        prob_io_status_t status;
+        prob_set_t *ps = prob_set_read(stdin, &status);
+        if (ps == NULL) {
+                fprintf(stderr, "bad input: %s\n", prob_io_strerror(status));
+                return 1;
+        }
+        printf("%8s %12s %14s %14s\n",
+               "threads", "generations", "gens/sec", "deterministic");
+        for (size_t threads=1; threads<=max_threads; threads*=2) {
+                ga_params_t params;
+                ga_params_init(&params);
+                params.num_threads = threads;
+                size_t gens = 0;
+                int deterministic = 1;
+                double t0 = mono_now();
+                result_t *first = NULL;
+                for (size_t r=0; r<NUM_RUNS; r++) {
+                        result_t *res = num_part_2way_params(ps, &params);
+                        gens += res->num_gens_passed;
+                        if (first == NULL) {
+                                first = res;
+                        } else {
+                                deterministic &= result_eq(first, res);
+                                result_free(res);
+                        }
+                }
+                double elapsed = mono_now() - t0;
+                result_free(first);
+                printf("%8zu %12zu %14.1f %14s\n", threads, gens,
+                       gens / elapsed, deterministic ? "yes" : "NO");
+        }
+        prob_set_free(ps);
+        return 0;
+}
+
+static int result_eq(const result_t *r1, const result_t *r2) {
+        return r1->num_gens_passed == r2->num_gens_passed
+               && r1->set0_count == r2->set0_count
+               && r1->set1_count == r2->set1_count
+               && memcmp(r1->words, r2->words,
+                         sizeof(uint64_t) * BITS2WORDS(r1->num_items)) == 0;
+}
@@ -0,0 +1,222 @@
+/** Implements function prototypes in ga-config.h
+ * @file ga-config.c */
+#include "ga-config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+
+/** Longest config file line read whole; longer lines are rejected */
+#define CONFIG_LINE_MAX                 1024
+
+/** Types of the fields of ga_params_t */
+enum param_type {
+        PARAM_SIZE,
+        PARAM_U64,
+        PARAM_LL,
+        PARAM_DOUBLE,
+        PARAM_BOOL,
+        PARAM_CROSSOVER,
+        PARAM_REPLACEMENT
+};
+/** Field of ga_params_t settable by name */
+struct param_field {
+        const char *key;
+        enum param_type type;
+        size_t offset;
+};
+
+static const struct param_field param_fields[] = {
+        {"pop_size_factor", PARAM_DOUBLE, offsetof(ga_params_t,
+                                                   pop_size_factor)},
+        {"pop_size_cap", PARAM_SIZE, offsetof(ga_params_t, pop_size_cap)},
+        {"memory_budget", PARAM_SIZE, offsetof(ga_params_t,
+                                               memory_budget)},
+        {"reduce_items", PARAM_SIZE, offsetof(ga_params_t, reduce_items)},
+        {"max_gens", PARAM_SIZE, offsetof(ga_params_t, max_gens)},
+        {"tourn_size", PARAM_SIZE, offsetof(ga_params_t, tourn_size)},
+        {"crossover", PARAM_CROSSOVER, offsetof(ga_params_t, crossover)},
+        {"replacement", PARAM_REPLACEMENT, offsetof(ga_params_t,
+                                                    replacement)},
+        {"target_diff", PARAM_LL, offsetof(ga_params_t, target_diff)},
+        {"stall_gens", PARAM_SIZE, offsetof(ga_params_t, stall_gens)},
+        {"time_limit", PARAM_DOUBLE, offsetof(ga_params_t, time_limit)},
+        {"mutation_rate", PARAM_DOUBLE, offsetof(ga_params_t,
+                                                 mutation_rate)},
+        {"seed", PARAM_U64, offsetof(ga_params_t, seed)},
+        {"stream", PARAM_U64, offsetof(ga_params_t, stream)},
+        {"threads", PARAM_SIZE, offsetof(ga_params_t, num_threads)},
+        {"islands", PARAM_SIZE, offsetof(ga_params_t, num_islands)},
+        {"migration_interval", PARAM_SIZE, offsetof(ga_params_t,
+                                                    migration_interval)},
+        {"migrants", PARAM_SIZE, offsetof(ga_params_t, num_migrants)},
+        {"delta_fitness", PARAM_BOOL, offsetof(ga_params_t, delta_fitness)},
+        {"fixed_width", PARAM_BOOL, offsetof(ga_params_t, fixed_width)},
+        {"seed_fraction", PARAM_DOUBLE, offsetof(ga_params_t,
+                                                 seed_fraction)},
+        {"local_search_k", PARAM_SIZE, offsetof(ga_params_t,
+                                                local_search_k)},
+        {"local_search_budget", PARAM_DOUBLE, offsetof(ga_params_t,
+                                                       local_search_budget)}
+};
+static const char *const crossover_names[] = {
+        [CROSSOVER_UNIFORM] = "uniform",
+        [CROSSOVER_ONE_POINT] = "one-point",
+        [CROSSOVER_TWO_POINT] = "two-point"
+};
+static const char *const replacement_names[] = {
+        [REPLACEMENT_GENERATIONAL] = "generational",
+        [REPLACEMENT_STEADY_STATE] = "steady-state"
+};
+
+/** Parses all of value as a signed integer */
+static bool parse_ll(const char *value, long long *out);
+/** Returns str with leading and trailing white space removed, in place */
+static char *trim(char *str);
+
+bool ga_params_set(ga_params_t *params, const char *key, const char *value) {
+        const struct param_field *field = NULL;
+        for (size_t f=0; f<sizeof(param_fields)/sizeof(*param_fields); f++) {
+                if (strcmp(param_fields[f].key, key) == 0) {
+                        field = param_fields + f;
+                        break;
+                }
+        }
+        if (field == NULL) {
+                return false;
+        }
+        char *dst = (char *)params + field->offset;
+        unsigned long long u;
+        long long ll;
+        double d;
+        switch (field->type) {
+        case PARAM_SIZE:
+                if (!config_parse_ull(value, &u) || u > SIZE_MAX) {
+                        return false;
+                }
+                *(size_t *)dst = u;
+                return true;
+        case PARAM_U64:
+                if (!config_parse_ull(value, &u)) {
+                        return false;
+                }
+                *(uint64_t *)dst = u;
+                return true;
+        case PARAM_LL:
+                if (!parse_ll(value, &ll)) {
+                        return false;
+                }
+                *(long long *)dst = ll;
+                return true;
+        case PARAM_DOUBLE:
+                if (!config_parse_double(value, &d)) {
+                        return false;
+                }
+                *(double *)dst = d;
+                return true;
+        case PARAM_BOOL:
+                if (strcmp(value, "1") == 0 || strcmp(value, "true") == 0) {
+                        *(bool *)dst = true;
+                } else if (strcmp(value, "0") == 0
+                           || strcmp(value, "false") == 0) {
+                        *(bool *)dst = false;
+                } else {
+                        return false;
+                }
+                return true;
+        case PARAM_CROSSOVER:
+                for (size_t c=0;
+                     c<sizeof(crossover_names)/sizeof(*crossover_names);
+                     c++) {
+                        if (strcmp(crossover_names[c], value) == 0) {
+                                *(crossover_t *)dst = (crossover_t)c;
+                                return true;
+                        }
+                }
+                return false;
+        case PARAM_REPLACEMENT:
+                for (size_t r=0;
+                     r<sizeof(replacement_names)/sizeof(*replacement_names);
+                     r++) {
+                        if (strcmp(replacement_names[r], value) == 0) {
+                                *(replacement_t *)dst = (replacement_t)r;
+                                return true;
+                        }
+                }
+                return false;
+        }
+        return false;
+}
+size_t config_read(FILE *in, config_setter_t set, void *arg) {
+        char line[CONFIG_LINE_MAX];
+        size_t line_num = 0;
+        while (fgets(line, sizeof(line), in) != NULL) {
+                line_num++;
+                size_t len = strlen(line);
+                if (len == sizeof(line) - 1 && line[len - 1] != '\n'
+                    && !feof(in)) {
+                        return line_num;
+                }
+                char *comment = strchr(line, '#');
+                if (comment != NULL) {
+                        *comment = '\0';
+                }
+                char *key = trim(line);
+                if (*key == '\0') {
+                        continue;
+                }
+                char *equals = strchr(key, '=');
+                if (equals == NULL) {
+                        return line_num;
+                }
+                *equals = '\0';
+                key = trim(key);
+                char *value = trim(equals + 1);
+                if (*key == '\0' || !set(arg, key, value)) {
+                        return line_num;
+                }
+        }
+        return 0;
+}
+
+bool config_parse_ull(const char *value, unsigned long long *out) {
+        /* strtoull accepts and negates a leading minus sign */
+        if (*value == '\0' || *value == '-'
+            || isspace((unsigned char)*value)) {
+                return false;
+        }
+        char *end;
+        errno = 0;
+        *out = strtoull(value, &end, 0);
+        return *end == '\0' && errno == 0;
+}
+static bool parse_ll(const char *value, long long *out) {
+        if (*value == '\0' || isspace((unsigned char)*value)) {
+                return false;
+        }
+        char *end;
+        errno = 0;
+        *out = strtoll(value, &end, 0);
+        return *end == '\0' && errno == 0;
+}
+bool config_parse_double(const char *value, double *out) {
+        if (*value == '\0' || isspace((unsigned char)*value)) {
+                return false;
+        }
+        char *end;
+        errno = 0;
+        *out = strtod(value, &end);
+        return *end == '\0' && errno == 0 && *out >= 0 && *out < HUGE_VAL;
+}
+static char *trim(char *str) {
+        while (isspace((unsigned char)*str)) {
+                str++;
+        }
+        size_t len = strlen(str);
+        while (len > 0 && isspace((unsigned char)str[len - 1])) {
+                len--;
+        }
+        str[len] = '\0';
+        return str;
+}
@@ -0,0 +1,33 @@
+#ifndef GA_CONFIG_H
+#define GA_CONFIG_H
+/** Header file to set the parameters of num_part_2way_params by name, from
+ * command-line options or "key = value" config files
+ * @file ga-config.h */
+
+#include "number-partition.h"
+#include <stdio.h>
+
+/** Callback receiving each key and value read from a config file; returns
+ * false to reject the line */
+typedef bool (*config_setter_t)(void *arg, const char *key,
+                                const char *value);
+
+/** Sets the field of params named key from its text value. Keys are the
+ * field names of ga_params_t except num_threads, num_islands and
+ * num_migrants, which are threads, islands and migrants; booleans take 0,
+ * 1, false or true, crossover takes uniform, one-point or two-point and
+ * replacement takes generational or steady-state. Returns false, leaving
+ * params unchanged, if the key is unknown or the value malformed */
+bool ga_params_set(ga_params_t *params, const char *key, const char *value);
+/** Parses all of value as an unsigned integer in any base strtoull
+ * accepts; returns false if anything else is left or it is out of range */
+bool config_parse_ull(const char *value, unsigned long long *out);
+/** Parses all of value as a finite, non-negative double */
+bool config_parse_double(const char *value, double *out);
+/** Passes every "key = value" line of in to set along with arg; blank lines
+ * and text from a '#' to the end of a line are skipped. Returns 0, or the
+ * number (from 1) of the first line that is malformed or that set rejects,
+ * after which nothing more is read */
+size_t config_read(FILE *in, config_setter_t set, void *arg);
+
+#endif /* !GA_CONFIG_H */
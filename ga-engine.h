@@ -0,0 +1,235 @@
+#ifndef GA_ENGINE_H
+#define GA_ENGINE_H
+/** Building blocks of the genetic algorithm shared by the engines behind
+ * num_part_2way_params; not part of the public number-partition.h API
+ * @file ga-engine.h */
+
+#include "number-partition.h"
+#include "population.h"
+#include "fitness.h"
+#include "ga-trace.h"
+#include "mono-clock.h"
+#include <time.h>
+
+/** Default max number of generations the algorithm will go through before
+ * terminating */
+#define MAX_GENS                        100
+/** Default scaling factor for population size based on problem instance
+ * input size */
+#define POP_SIZE_FACTOR                 1
+/** Default number of chromosomes per tournament */
+#define TOURN_SIZE                      2
+/** An offspring is evaluated from a parent's difference when it differs from
+ * it in at most num_items / DELTA_FITNESS_DIV bits; beyond that walking the
+ * differing bits costs more than the batch evaluator */
+#define DELTA_FITNESS_DIV               32
+/** new_gen stops looking for close parents for the rest of a generation after
+ * this many offspring in a row were too far from theirs, as happens while
+ * the population is still diverse */
+#define DELTA_FITNESS_PROBES            8
+/** Fewest chromosomes a memory budget must leave room for; instances too
+ * large for that are reduced until it does */
+#define BUDGET_MIN_POP                  64
+/** Bytes the run needs per chromosome of NUM_ITEMS bits: its words,
+ * difference and unfitness in both arenas and its mating pool entry */
+#define GA_CHROM_BYTES(NUM_ITEMS) \
+        (2 * (sizeof(uint64_t) * BITS2WORDS(NUM_ITEMS) \
+              + 2 * sizeof(long long)) \
+         + sizeof(size_t))
+/** Most chromosomes per population of the fixed-width engines, whose
+ * populations live on the stack; larger runs use the general engine */
+#define FIXED_MAX_POP                   1024
+
+typedef struct ga_ctx ga_ctx_t;
+/** Read-only state of a run shared by every engine, thread and island */
+struct ga_ctx {
+        const long long *item_vals;
+        size_t num_items;
+        /** Number of chromosomes over all threads or islands */
+        size_t pop_size;
+        size_t max_gens;
+        size_t tourn_size;
+        crossover_t crossover;
+        /** Best unfitness at which the run stops, as a fitness_key */
+        long long target_diff;
+        /** Generations without improvement after which the run stops; 0
+         * means never */
+        size_t stall_gens;
+        /** Whether deadline is set */
+        bool has_deadline;
+        /** CLOCK_MONOTONIC time after which the run stops */
+        struct timespec deadline;
+        /** Accumulator width chosen for the instance when the run starts */
+        fitness_width_t width;
+        /** Sum of all item values; fits in a long long if width is
+         * FITNESS_NARROW */
+        __int128 total;
+        /** fitness_key_shift of the instance, 0 if width is
+         * FITNESS_NARROW */
+        unsigned key_shift;
+        /** Probability of flipping each bit during mutation */
+        double mutation_rate;
+        /** Whether offspring are evaluated from their parents' differences
+         * rather than from scratch */
+        bool delta_fitness;
+        /** Fraction of each population seeded by seed_chrom */
+        double seed_fraction;
+        /** Number of fittest offspring per generation passed through
+         * local_search; 0 for FITNESS_WIDE instances */
+        size_t ls_top_k;
+        /** Seconds of local search allowed per generation and slice; 0 means
+         * none */
+        double ls_budget;
+        /** Item indices by decreasing value; only set if seed_fraction > 0
+         * or ls_top_k > 0, or if given by ga_params_t */
+        const size_t *sorted;
+        /** sorted if the run sorted the items itself, else NULL */
+        size_t *owned_sorted;
+        /** Collector of the run's telemetry, or NULL */
+        ga_trace_t *trace;
+};
+
+/** Number of heap allocations made through ga_malloc or ga_aligned_alloc by
+ * the calling thread, for telemetry; population arenas, which population.c
+ * allocates for programs without the engine too, are not counted */
+extern _Thread_local size_t ga_num_allocs;
+/** malloc, counted in ga_num_allocs; the engine allocates through it */
+void *ga_malloc(size_t size);
+/** aligned_alloc, counted in ga_num_allocs like ga_malloc; size must be a
+ * multiple of alignment */
+void *ga_aligned_alloc(size_t alignment, size_t size);
+/** Starts timing phases into phase_seconds at *lap; does nothing if
+ * phase_seconds is NULL */
+void ga_lap_start(double *phase_seconds, struct timespec *lap);
+/** Adds the seconds since *lap to phase_seconds[phase] and restarts *lap;
+ * does nothing if phase_seconds is NULL */
+void ga_lap(double *phase_seconds, ga_phase_t phase, struct timespec *lap);
+/** Fills the best and mean unfitness and the diversity of rec from pop,
+ * turning the keys of a FITNESS_WIDE instance back into unfitness values */
+void ga_record_pop(ga_gen_record_t *rec, const pop_arena_t *pop,
+                   const ga_ctx_t *ctx);
+
+/** Returns the number of chromosomes of a run over num_items items:
+ * pop_size_factor times num_items, scaled down past pop_size_cap and
+ * shrunk to fit memory_budget, but at least 1 */
+size_t ga_pop_size(const ga_params_t *params, size_t num_items);
+/** Returns the number of items a run over num_items items searches:
+ * num_items unless reduce_items or memory_budget requires a smaller
+ * residual instance, but at least 1 */
+size_t ga_residual_items(const ga_params_t *params, size_t num_items);
+/** Fills ctx from the problem set and the parameters of the run
+ * @post                ctx must be freed (via ga_ctx_free) */
+void ga_ctx_init(ga_ctx_t *ctx, const prob_set_t *ps,
+                 const ga_params_t *params);
+/** Frees what ga_ctx_init allocated; ctx itself is not freed */
+void ga_ctx_free(ga_ctx_t *ctx);
+/** Returns whether a run that has passed num_gens_passed generations, the
+ * last stall_gens of them without improving on best_unfitness, is over;
+ * the deadline is not checked here since threads must agree on it */
+bool ga_converged(const ga_ctx_t *ctx, size_t num_gens_passed,
+                  long long best_unfitness, size_t stall_gens);
+/** Returns whether the deadline of the run, if any, has passed */
+bool ga_past_deadline(const ga_ctx_t *ctx);
+/** Writes the k-th heuristic seed into words, normalized: k=0 is the Largest
+ * Differencing Method's partition, k=1 the greedy partition over items by
+ * decreasing value and every later k a greedy partition over that order
+ * with neighbors randomly swapped
+ * @pre                 ctx->sorted is set */
+void seed_chrom(uint64_t *words, size_t k, const ga_ctx_t *ctx, rng_t *rng);
+/** Finds the fittest chromosome among indices [lo, hi) and returns its
+ * index */
+size_t find_fittest(const pop_arena_t *pop, size_t lo, size_t hi);
+/** Fills chromosomes [lo, hi) of pop with random bits, or with heuristic
+ * seeds for the first ctx->seed_fraction of the population, and calculates
+ * their fitness */
+void initial_pop(pop_arena_t *pop, size_t lo, size_t hi,
+                 const ga_ctx_t *ctx, rng_t *rng);
+/** Calculates the fitness of chromosomes [lo, hi) of a population from
+ * scratch and modifies their differences and unfitness values accordingly;
+ * for FITNESS_WIDE instances the unfitness is stored as its fitness_key
+ * under ctx->key_shift and the difference as the key with its sign, so
+ * chromosomes still rank in order of their true unfitness */
+void pop_calc_fitness(pop_arena_t *pop, size_t lo, size_t hi,
+                      const ga_ctx_t *ctx);
+/** Same as pop_calc_fitness for the group_size (at most FITNESS_GROUP)
+ * chromosomes of pop listed in indices, which are evaluated together */
+void calc_fitness_group(pop_arena_t *pop, const size_t *indices,
+                        size_t group_size, const ga_ctx_t *ctx);
+/** Performs tournaments of ctx->tourn_size chromosomes drawn from all of
+ * pop, filling entries [lo, hi) of the mating pool with the indices of the
+ * winners; ties go to the first drawn. Sizes 2 to 4 have their own unrolled
+ * instances */
+void tourn_select(const pop_arena_t *pop, size_t *pool,
+                  size_t lo, size_t hi, const ga_ctx_t *ctx, rng_t *rng);
+/** Evaluates child from whichever of chromosomes p1i and p2i of pop, or
+ * their inverses, it is closest to, storing its difference in diff; returns
+ * false without evaluating if even the closest differs in more than
+ * num_bits / DELTA_FITNESS_DIV bits, beyond which the batch evaluator is
+ * cheaper
+ * @pre                 ctx->width is FITNESS_NARROW */
+bool child_diff_from_parents(const pop_arena_t *pop, size_t p1i,
+                             size_t p2i, const uint64_t *child,
+                             const ga_ctx_t *ctx, long long *diff);
+/** Overwrites chromosomes [lo, hi) of next with offspring bred by
+ * ctx->crossover from the chromosomes of pop listed in the (complete) mating
+ * pool, mutating the
+ * offspring and calculating their fitness
+ *
+ * With ctx->delta_fitness set (never for FITNESS_WIDE instances), an
+ * offspring close to one of its parents (or to a parent's inverse) is
+ * evaluated from that parent's difference in O(bits that differ); the others
+ * are evaluated from scratch in batches. Building with FITNESS_CHECK defined
+ * checks every incremental difference against a full recomputation. The
+ * offspring then go through local_search if ctx->ls_top_k is set
+ * @param stats         counters added to if not NULL
+ * @param phase_seconds if not NULL, the seconds of the breed, fitness and
+ *                      local search phases are added to it */
+void new_gen(const pop_arena_t *pop, const size_t *pool,
+             pop_arena_t *next, size_t lo, size_t hi,
+             const ga_ctx_t *ctx, rng_t *rng, ga_stats_t *stats,
+             double *phase_seconds);
+/** Improves the share of the ctx->ls_top_k fittest chromosomes of pop that
+ * falls in [lo, hi) by steepest descent: each step makes the single-item
+ * move or pairwise swap between the sets that lowers the unfitness most,
+ * found through binary searches of ctx->sorted, until none does or the
+ * ctx->ls_budget of the call runs out. Differences and unfitness are kept
+ * up to date and chromosomes stay normalized
+ * @pre                 ctx->width is FITNESS_NARROW
+ * @param stats         counters added to if not NULL */
+void local_search(pop_arena_t *pop, size_t lo, size_t hi,
+                  const ga_ctx_t *ctx, ga_stats_t *stats);
+
+/** Runs a single-threaded, single-population run over at most 1024 items
+ * with chromosomes of a width fixed at compile time (64, 128, 256 or 1024
+ * bits, the narrowest that fits), returning the same result as the general
+ * engine would. Nothing is allocated until the result, except by heuristic
+ * seeds. Returns NULL if the run needs anything those engines leave out:
+ * threads, islands, tracing, local search, FITNESS_WIDE accumulation or more
+ * than FIXED_MAX_POP chromosomes, or if params->fixed_width is unset
+ * @param stats         zeroed if not NULL and a result is returned */
+result_t *num_part_2way_fixed(const prob_set_t *ps,
+                              const ga_params_t *params,
+                              const ga_ctx_t *ctx, ga_stats_t *stats);
+/** Runs a steady-state run on the calling thread: each offspring replaces
+ * the least fit chromosome of a single population in place if it is fitter
+ * and no chromosome of the population has the same bits, so the best
+ * chromosome is never lost. A heap ordered by unfitness finds the least fit
+ * chromosome in O(1) and restores itself in O(log pop_size) after each
+ * replacement, and a hash table of the chromosomes finds duplicates in
+ * O(1). A generation is ctx->pop_size offspring; the run stops as soon as
+ * an offspring reaches ctx->target_diff. Threads, islands and local search
+ * are not used
+ * @param stats         zeroed if not NULL */
+result_t *num_part_2way_steady(const prob_set_t *ps,
+                               const ga_params_t *params,
+                               const ga_ctx_t *ctx, ga_stats_t *stats);
+/** Runs the island model: params->num_islands sub-populations, each on its
+ * own thread, exchanging their best chromosomes over a ring. An island that
+ * reaches ctx->target_diff stops; the others stop at the next migration
+ * boundary, so the result does not depend on timing
+ * @param stats         filled in if not NULL */
+result_t *num_part_2way_islands(const prob_set_t *ps,
+                                const ga_params_t *params,
+                                const ga_ctx_t *ctx, ga_stats_t *stats);
+
+#endif /* !GA_ENGINE_H */
@@ -0,0 +1,587 @@
+/** Sweeps a grid of genetic algorithm parameters over every dataset of a
+ * directory, recording per configuration how often and how fast runs reach
+ * a target difference and how the final differences are distributed, then
+ * suggests the Pareto-best configurations of each instance size class
+ * @file ga-sweep.c */
+#include "number-partition.h"
+#include "differencing.h"
+#include "ga-config.h"
+#include "prob-io.h"
+#include "mono-clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+
+/** Max number of grid axes */
+#define MAX_AXES                8
+/** Max number of values per axis */
+#define MAX_AXIS_VALS           16
+/** Default number of runs per configuration and dataset */
+#define NUM_RUNS                3
+/** Axis handled by the sweep rather than ga_params_set: the expected number
+ * of bits flipped per chromosome, i.e. the mutation rate times the number
+ * of items */
+#define MUTATION_BITS_KEY       "mutation_bits"
+
+/** Grid axis: a key of ga_params_set (or MUTATION_BITS_KEY) and the values
+ * it takes */
+struct axis {
+        char *key;
+        size_t num_vals;
+        char *vals[MAX_AXIS_VALS];
+};
+struct dataset {
+        char *name;
+        /** Leading letters of the file name followed by the item count,
+         * e.g. randbound100 */
+        char *class_name;
+        prob_set_t *ps;
+        /** Difference of the Largest Differencing Method's partition */
+        long double kk_diff;
+};
+/** Outcome of one run */
+struct run {
+        long double diff;
+        double seconds;
+        size_t num_gens;
+        bool reached;
+};
+/** Whole sweep; runs are indexed by config, then dataset, then repetition,
+ * and handed out to the threads in that order */
+struct sweep {
+        struct axis axes[MAX_AXES];
+        size_t num_axes;
+        size_t num_configs;
+        struct dataset *datasets;
+        size_t num_datasets;
+        size_t num_runs;
+        uint64_t seed;
+        /** Whether the target is a perfect partition rather than the Largest
+         * Differencing Method's difference */
+        bool perfect_target;
+        struct run *runs;
+        size_t next_run;
+        pthread_mutex_t lock;
+};
+/** Summary of the runs of one configuration over one dataset or class */
+struct summary {
+        size_t count;
+        size_t reached;
+        /** Median seconds of the runs that reached the target; negative if
+         * none did */
+        double median_ttt;
+        double mean_seconds;
+        double mean_gens;
+        long double diff_min;
+        long double diff_median;
+        long double diff_mean;
+        long double diff_max;
+        /** Mean of each final difference over the dataset's kk_diff + 1 */
+        long double mean_rel_diff;
+};
+
+/** Adds an axis from a key=v1,v2,... specification; returns false if it is
+ * malformed or its key unknown */
+static bool add_axis(struct sweep *sweep, const char *spec);
+/** Reads every dataset of dir, sorted by name */
+static bool load_datasets(struct sweep *sweep, const char *dir);
+/** Returns the problem set in the file at path, or NULL if malformed */
+static prob_set_t *read_prob_set(const char *path);
+/** Fills params for repetition rep of config on dataset */
+static void config_params(const struct sweep *sweep, size_t config,
+                          const struct dataset *dataset, size_t rep,
+                          ga_params_t *params);
+/** Returns the value of axis a in config */
+static const char *config_val(const struct sweep *sweep, size_t config,
+                              size_t a);
+/** Body of every thread: claims and performs runs until none are left */
+static void *run_sweep(void *sweep);
+/** Summarizes the runs of config over the datasets whose class is
+ * class_name, or over dataset d alone if class_name is NULL */
+static void summarize(const struct sweep *sweep, size_t config,
+                      const char *class_name, size_t d,
+                      struct summary *sum);
+/** Writes one line per configuration and dataset, as CSV or JSON lines */
+static void write_report(const struct sweep *sweep, FILE *out, bool json);
+/** Prints the configurations of each class that no other beats on success
+ * rate, mean seconds and mean relative difference all at once */
+static void print_pareto(const struct sweep *sweep);
+static int cmp_double(const void *a, const void *b);
+static int cmp_long_double(const void *a, const void *b);
+static int cmp_dataset(const void *a, const void *b);
+/** Prints the usage of the sweep, run as prog, on stderr */
+static void print_usage(const char *prog);
+
+/* Usage: ga-sweep.out [-d dir] [-a key=v1,v2,...]... [-r runs] [-j jobs]
+ *                     [-s seed] [-p] [-o report.csv|report.json]
+ * -d           directory of datasets; defaults to datasets
+ * -a           grid axis; the first -a replaces the default grid of
+ *              pop_size_factor=0.5,1,2 mutation_bits=0.5,1,2
+ *              tourn_size=2,3,4 max_gens=100,300. Keys are those of
+ *              ga_params_set plus mutation_bits, the expected number of bits
+ *              flipped per chromosome
+ * -r           runs per configuration and dataset; run i uses random stream
+ *              i of the seed in every configuration; defaults to 3
+ * -j           runs performed at the same time; defaults to 1
+ * -s           seed; defaults to 0 so that sweeps are repeatable
+ * -p           target a perfect partition rather than the difference of the
+ *              Largest Differencing Method's partition
+ * -o           writes one line per configuration and dataset to the file,
+ *              as JSON lines if its name ends in .json and as CSV otherwise
+ * The Pareto-best configurations of each class are printed on stdout */
+int main(int argc, char **argv) {
+        struct sweep sweep = {.num_runs = NUM_RUNS};
+        const char *dir = "datasets";
+        const char *report_path = NULL;
+        size_t num_jobs = 1;
+        int opt;
+        unsigned long long val;
+        while ((opt = getopt(argc, argv, "d:a:r:j:s:po:")) != -1) {
+                switch (opt) {
+                case 'd':
+                        dir = optarg;
+                        break;
+                case 'a':
+                        if (!add_axis(&sweep, optarg)) {
+                                fprintf(stderr, "bad axis: %s\n", optarg);
+                                print_usage(argv[0]);
+                                return 1;
+                        }
+                        break;
+                case 'r':
+                case 'j':
+                case 's':
+                        if (!config_parse_ull(optarg, &val)
+                            || (opt != 's' && val > SIZE_MAX)) {
+                                fprintf(stderr, "bad -%c: %s\n", opt,
+                                        optarg);
+                                print_usage(argv[0]);
+                                return 1;
+                        }
+                        if (opt == 'r') {
+                                sweep.num_runs = val;
+                        } else if (opt == 'j') {
+                                num_jobs = val;
+                        } else {
+                                sweep.seed = val;
+                        }
+                        break;
+                case 'p':
+                        sweep.perfect_target = true;
+                        break;
+                case 'o':
+                        report_path = optarg;
+                        break;
+                default:
+                        print_usage(argv[0]);
+                        return 1;
+                }
+        }
+        if (sweep.num_axes == 0) {
+                const char *defaults[] = {"pop_size_factor=0.5,1,2",
+                                          MUTATION_BITS_KEY "=0.5,1,2",
+                                          "tourn_size=2,3,4",
+                                          "max_gens=100,300"};
+                for (size_t a=0; a<sizeof(defaults)/sizeof(*defaults); a++) {
+                        add_axis(&sweep, defaults[a]);
+                }
+        }
+        if (sweep.num_runs == 0) {
+                sweep.num_runs = 1;
+        }
+        if (num_jobs == 0) {
+                num_jobs = 1;
+        }
+        if (!load_datasets(&sweep, dir)) {
+                return 1;
+        }
+        sweep.num_configs = 1;
+        for (size_t a=0; a<sweep.num_axes; a++) {
+                sweep.num_configs *= sweep.axes[a].num_vals;
+        }
+        size_t total_runs = sweep.num_configs * sweep.num_datasets
+                            * sweep.num_runs;
+        sweep.runs = malloc(sizeof(*sweep.runs) * total_runs);
+        pthread_mutex_init(&sweep.lock, NULL);
+        fprintf(stderr, "%zu configurations x %zu datasets x %zu runs\n",
+                sweep.num_configs, sweep.num_datasets, sweep.num_runs);
+        pthread_t *threads = malloc(sizeof(*threads) * num_jobs);
+        for (size_t t=0; t<num_jobs; t++) {
+                pthread_create(threads + t, NULL, run_sweep, &sweep);
+        }
+        for (size_t t=0; t<num_jobs; t++) {
+                pthread_join(threads[t], NULL);
+        }
+        free(threads);
+        pthread_mutex_destroy(&sweep.lock);
+        if (report_path != NULL) {
+                FILE *out = fopen(report_path, "w");
+                if (out == NULL) {
+                        perror(report_path);
+                        return 1;
+                }
+                size_t len = strlen(report_path);
+                write_report(&sweep, out,
+                             len >= 5
+                             && strcmp(report_path + len - 5, ".json") == 0);
+                fclose(out);
+        }
+        print_pareto(&sweep);
+        for (size_t d=0; d<sweep.num_datasets; d++) {
+                free(sweep.datasets[d].name);
+                free(sweep.datasets[d].class_name);
+                prob_set_free(sweep.datasets[d].ps);
+        }
+        for (size_t a=0; a<sweep.num_axes; a++) {
+                free(sweep.axes[a].key);
+        }
+        free(sweep.datasets);
+        free(sweep.runs);
+        return 0;
+}
+
+static bool add_axis(struct sweep *sweep, const char *spec) {
+        char *equals = strchr(spec, '=');
+        if (sweep->num_axes == MAX_AXES || equals == NULL) {
+                return false;
+        }
+        /* the key and the values share one allocation, split in place */
+        struct axis *axis = sweep->axes + sweep->num_axes;
+        axis->key = strdup(spec);
+        axis->key[equals - spec] = '\0';
+        axis->num_vals = 0;
+        char *save;
+        for (char *val = strtok_r(axis->key + (equals - spec) + 1, ",",
+                                  &save);
+             val != NULL; val = strtok_r(NULL, ",", &save)) {
+                ga_params_t params;
+                ga_params_init(&params);
+                bool valid = (strcmp(axis->key, MUTATION_BITS_KEY) == 0)
+                             ? ga_params_set(&params, "mutation_rate", val)
+                             : ga_params_set(&params, axis->key, val);
+                if (!valid || axis->num_vals == MAX_AXIS_VALS) {
+                        free(axis->key);
+                        return false;
+                }
+                axis->vals[axis->num_vals++] = val;
+        }
+        if (axis->num_vals == 0) {
+                free(axis->key);
+                return false;
+        }
+        sweep->num_axes++;
+        return true;
+}
+static bool load_datasets(struct sweep *sweep, const char *dir) {
+        DIR *dp = opendir(dir);
+        if (dp == NULL) {
+                perror(dir);
+                return false;
+        }
+        size_t capacity = 16;
+        sweep->datasets = malloc(sizeof(*sweep->datasets) * capacity);
+        sweep->num_datasets = 0;
+        struct dirent *entry;
+        while ((entry = readdir(dp)) != NULL) {
+                if (entry->d_name[0] == '.') {
+                        continue;
+                }
+                size_t path_len = strlen(dir) + strlen(entry->d_name) + 2;
+                char *path = malloc(path_len);
+                snprintf(path, path_len, "%s/%s", dir, entry->d_name);
+                prob_set_t *ps = read_prob_set(path);
+                free(path);
+                if (ps == NULL) {
+                        fprintf(stderr, "skipping %s\n", entry->d_name);
+                        continue;
+                }
+                if (sweep->num_datasets == capacity) {
+                        capacity *= 2;
+                        sweep->datasets = realloc(sweep->datasets,
+                                                  sizeof(*sweep->datasets)
+                                                  * capacity);
+                }
+                struct dataset *dataset = sweep->datasets
+                                          + sweep->num_datasets++;
+                dataset->name = strdup(entry->d_name);
+                dataset->ps = ps;
+                size_t family_len = 0;
+                while (isalpha((unsigned char)entry->d_name[family_len])) {
+                        family_len++;
+                }
+                size_t class_len = family_len + 24;
+                dataset->class_name = malloc(class_len);
+                snprintf(dataset->class_name, class_len, "%.*s%zu",
+                         (int)family_len, entry->d_name, ps->num_items);
+                result_t *kk = num_part_2way_kk(ps);
+                dataset->kk_diff = (long double)result_diff(kk);
+                result_free(kk);
+        }
+        closedir(dp);
+        if (sweep->num_datasets == 0) {
+                fprintf(stderr, "no datasets in %s\n", dir);
+                return false;
+        }
+        qsort(sweep->datasets, sweep->num_datasets,
+              sizeof(*sweep->datasets), cmp_dataset);
+        return true;
+}
+static prob_set_t *read_prob_set(const char *path) {
+        FILE *in = fopen(path, "r");
+        if (in == NULL) {
+                return NULL;
+        }
+        prob_set_t *ps = prob_set_read(in, NULL);
+        fclose(in);
+        if (ps != NULL && ps->num_items == 0) {
+                prob_set_free(ps);
+                return NULL;
+        }
+        return ps;
+}
+static const char *config_val(const struct sweep *sweep, size_t config,
+                              size_t a) {
+        /* configs count in mixed radix, the last axis varying fastest */
+        for (size_t b=sweep->num_axes; b-->a+1;) {
+                config /= sweep->axes[b].num_vals;
+        }
+        return sweep->axes[a].vals[config % sweep->axes[a].num_vals];
+}
+static void config_params(const struct sweep *sweep, size_t config,
+                          const struct dataset *dataset, size_t rep,
+                          ga_params_t *params) {
+        ga_params_init(params);
+        params->seed = sweep->seed;
+        params->stream = rep;
+        params->target_diff = (sweep->perfect_target
+                               || dataset->kk_diff > LLONG_MAX)
+                              ? 0
+                              : (long long)dataset->kk_diff;
+        for (size_t a=0; a<sweep->num_axes; a++) {
+                const char *val = config_val(sweep, config, a);
+                if (strcmp(sweep->axes[a].key, MUTATION_BITS_KEY) == 0) {
+                        /* add_axis checked the value */
+                        double mutation_bits = 0;
+                        config_parse_double(val, &mutation_bits);
+                        params->mutation_rate = mutation_bits
+                                                / dataset->ps->num_items;
+                } else {
+                        ga_params_set(params, sweep->axes[a].key, val);
+                }
+        }
+}
+static void *run_sweep(void *sweep_ptr) {
+        struct sweep *sweep = (struct sweep *)sweep_ptr;
+        size_t total_runs = sweep->num_configs * sweep->num_datasets
+                            * sweep->num_runs;
+        while (true) {
+                pthread_mutex_lock(&sweep->lock);
+                size_t r = sweep->next_run++;
+                pthread_mutex_unlock(&sweep->lock);
+                if (r >= total_runs) {
+                        break;
+                }
+                size_t rep = r % sweep->num_runs;
+                size_t d = r / sweep->num_runs % sweep->num_datasets;
+                size_t config = r / sweep->num_runs / sweep->num_datasets;
+                const struct dataset *dataset = sweep->datasets + d;
+                ga_params_t params;
+                config_params(sweep, config, dataset, rep, &params);
+                double t0 = mono_now();
+                result_t *res = num_part_2way_params(dataset->ps, &params);
+                double seconds = mono_now() - t0;
+                struct run *run = sweep->runs + r;
+                run->diff = (long double)result_diff(res);
+                run->seconds = seconds;
+                run->num_gens = res->num_gens_passed;
+                run->reached = run->diff <= (long double)params.target_diff;
+                result_free(res);
+        }
+        return NULL;
+}
+static void summarize(const struct sweep *sweep, size_t config,
+                      const char *class_name, size_t d,
+                      struct summary *sum) {
+        size_t max_count = sweep->num_datasets * sweep->num_runs;
+        long double *diffs = malloc(sizeof(*diffs) * max_count);
+        double *ttts = malloc(sizeof(*ttts) * max_count);
+        *sum = (struct summary){0};
+        double total_seconds = 0;
+        size_t total_gens = 0;
+        long double total_diff = 0;
+        long double total_rel = 0;
+        for (size_t e=0; e<sweep->num_datasets; e++) {
+                const struct dataset *dataset = sweep->datasets + e;
+                if ((class_name == NULL) ? e != d
+                    : strcmp(dataset->class_name, class_name) != 0) {
+                        continue;
+                }
+                for (size_t rep=0; rep<sweep->num_runs; rep++) {
+                        const struct run *run = sweep->runs
+                                + (config * sweep->num_datasets + e)
+                                  * sweep->num_runs
+                                + rep;
+                        diffs[sum->count++] = run->diff;
+                        if (run->reached) {
+                                ttts[sum->reached++] = run->seconds;
+                        }
+                        total_seconds += run->seconds;
+                        total_gens += run->num_gens;
+                        total_diff += run->diff;
+                        total_rel += run->diff / (dataset->kk_diff + 1);
+                }
+        }
+        qsort(diffs, sum->count, sizeof(*diffs), cmp_long_double);
+        qsort(ttts, sum->reached, sizeof(*ttts), cmp_double);
+        sum->median_ttt = (sum->reached > 0) ? ttts[sum->reached / 2] : -1;
+        sum->mean_seconds = total_seconds / sum->count;
+        sum->mean_gens = (double)total_gens / sum->count;
+        sum->diff_min = diffs[0];
+        sum->diff_median = diffs[sum->count / 2];
+        sum->diff_mean = total_diff / sum->count;
+        sum->diff_max = diffs[sum->count - 1];
+        sum->mean_rel_diff = total_rel / sum->count;
+        free(diffs);
+        free(ttts);
+}
+static void write_report(const struct sweep *sweep, FILE *out, bool json) {
+        if (!json) {
+                fputs("dataset,class,num_items,kk_diff", out);
+                for (size_t a=0; a<sweep->num_axes; a++) {
+                        fprintf(out, ",%s", sweep->axes[a].key);
+                }
+                fputs(",runs,reached,median_ttt,mean_seconds,mean_gens,"
+                      "diff_min,diff_median,diff_mean,diff_max\n", out);
+        }
+        for (size_t config=0; config<sweep->num_configs; config++) {
+                for (size_t d=0; d<sweep->num_datasets; d++) {
+                        const struct dataset *dataset = sweep->datasets + d;
+                        struct summary sum;
+                        summarize(sweep, config, NULL, d, &sum);
+                        if (json) {
+                                fprintf(out, "{\"dataset\": \"%s\", "
+                                        "\"class\": \"%s\", "
+                                        "\"num_items\": %zu, "
+                                        "\"kk_diff\": %.0Lf",
+                                        dataset->name, dataset->class_name,
+                                        dataset->ps->num_items,
+                                        dataset->kk_diff);
+                                for (size_t a=0; a<sweep->num_axes; a++) {
+                                        fprintf(out, ", \"%s\": \"%s\"",
+                                                sweep->axes[a].key,
+                                                config_val(sweep, config,
+                                                           a));
+                                }
+                                fprintf(out, ", \"runs\": %zu, "
+                                        "\"reached\": %zu, ",
+                                        sum.count, sum.reached);
+                                if (sum.reached > 0) {
+                                        fprintf(out, "\"median_ttt\": %f, ",
+                                                sum.median_ttt);
+                                } else {
+                                        fputs("\"median_ttt\": null, ", out);
+                                }
+                                fprintf(out, "\"mean_seconds\": %f, "
+                                        "\"mean_gens\": %f, "
+                                        "\"diff_min\": %.0Lf, "
+                                        "\"diff_median\": %.0Lf, "
+                                        "\"diff_mean\": %.2Lf, "
+                                        "\"diff_max\": %.0Lf}\n",
+                                        sum.mean_seconds, sum.mean_gens,
+                                        sum.diff_min, sum.diff_median,
+                                        sum.diff_mean, sum.diff_max);
+                                continue;
+                        }
+                        fprintf(out, "%s,%s,%zu,%.0Lf", dataset->name,
+                                dataset->class_name, dataset->ps->num_items,
+                                dataset->kk_diff);
+                        for (size_t a=0; a<sweep->num_axes; a++) {
+                                fprintf(out, ",%s",
+                                        config_val(sweep, config, a));
+                        }
+                        fprintf(out, ",%zu,%zu,", sum.count, sum.reached);
+                        if (sum.reached > 0) {
+                                fprintf(out, "%f", sum.median_ttt);
+                        }
+                        fprintf(out, ",%f,%f,%.0Lf,%.0Lf,%.2Lf,%.0Lf\n",
+                                sum.mean_seconds, sum.mean_gens,
+                                sum.diff_min, sum.diff_median,
+                                sum.diff_mean, sum.diff_max);
+                }
+        }
+}
+static void print_pareto(const struct sweep *sweep) {
+        struct summary *sums = malloc(sizeof(*sums) * sweep->num_configs);
+        for (size_t d=0; d<sweep->num_datasets; d++) {
+                const char *class_name = sweep->datasets[d].class_name;
+                /* each class is printed once, at its first dataset */
+                bool seen = false;
+                for (size_t e=0; e<d; e++) {
+                        seen |= strcmp(sweep->datasets[e].class_name,
+                                       class_name) == 0;
+                }
+                if (seen) {
+                        continue;
+                }
+                for (size_t c=0; c<sweep->num_configs; c++) {
+                        summarize(sweep, c, class_name, 0, sums + c);
+                }
+                printf("%s (target: %s):\n", class_name,
+                       sweep->perfect_target ? "perfect partition"
+                                             : "differencing method");
+                for (size_t c=0; c<sweep->num_configs; c++) {
+                        bool dominated = false;
+                        for (size_t o=0; o<sweep->num_configs && !dominated;
+                             o++) {
+                                const struct summary *a = sums + o;
+                                const struct summary *b = sums + c;
+                                dominated = a->reached >= b->reached
+                                            && a->mean_seconds
+                                               <= b->mean_seconds
+                                            && a->mean_rel_diff
+                                               <= b->mean_rel_diff
+                                            && (a->reached > b->reached
+                                                || a->mean_seconds
+                                                   < b->mean_seconds
+                                                || a->mean_rel_diff
+                                                   < b->mean_rel_diff);
+                        }
+                        if (dominated) {
+                                continue;
+                        }
+                        printf(" ");
+                        for (size_t a=0; a<sweep->num_axes; a++) {
+                                printf(" %s=%s", sweep->axes[a].key,
+                                       config_val(sweep, c, a));
+                        }
+                        printf(": reached %zu/%zu, %.4f s/run, "
+                               "relative diff %.3Lf\n",
+                               sums[c].reached, sums[c].count,
+                               sums[c].mean_seconds, sums[c].mean_rel_diff);
+                }
+        }
+        free(sums);
+}
+static int cmp_double(const void *a, const void *b) {
+        double da = *(const double *)a;
+        double db = *(const double *)b;
+        return (da > db) - (da < db);
+}
+static int cmp_long_double(const void *a, const void *b) {
+        long double da = *(const long double *)a;
+        long double db = *(const long double *)b;
+        return (da > db) - (da < db);
+}
+static int cmp_dataset(const void *a, const void *b) {
+        return strcmp(((const struct dataset *)a)->name,
+                      ((const struct dataset *)b)->name);
+}
+static void print_usage(const char *prog) {
+        fprintf(stderr, "usage: %s [-d dir] [-a key=v1,v2,...]... [-r runs] "
+                "[-j jobs] [-s seed] [-p] [-o report]\n", prog);
+}
@@ -0,0 +1,122 @@
+/** Implements function prototypes in ga-trace.h, along with the telemetry
+ * helpers of the engine declared in ga-engine.h
+ * @file ga-trace.c */
+#include "ga-trace.h"
+#include "ga-engine.h"
+#include <stdlib.h>
+#include <limits.h>
+
+/** Most pairs of chromosomes compared to estimate the diversity of a
+ * population */
+#define DIVERSITY_PAIRS         64
+
+_Thread_local size_t ga_num_allocs = 0;
+
+ga_trace_t *ga_trace_malloc(size_t capacity, ga_trace_fn_t *callback,
+                            void *context) {
+        ga_trace_t *trace = malloc(sizeof(*trace));
+        trace->callback = callback;
+        trace->context = context;
+        trace->capacity = (capacity > 0) ? capacity : 1;
+        trace->ring = malloc(sizeof(*trace->ring) * trace->capacity);
+        pthread_mutex_init(&trace->lock, NULL);
+        ga_trace_reset(trace);
+        return trace;
+}
+void ga_trace_free(ga_trace_t *trace) {
+        pthread_mutex_destroy(&trace->lock);
+        free(trace->ring);
+        free(trace);
+}
+void ga_trace_reset(ga_trace_t *trace) {
+        trace->num_records = 0;
+        for (size_t p=0; p<GA_NUM_PHASES; p++) {
+                trace->phase_seconds[p] = 0;
+        }
+        trace->num_allocs = 0;
+}
+void ga_trace_add(ga_trace_t *trace, const ga_gen_record_t *rec) {
+        pthread_mutex_lock(&trace->lock);
+        trace->ring[trace->num_records % trace->capacity] = *rec;
+        trace->num_records++;
+        for (size_t p=0; p<GA_NUM_PHASES; p++) {
+                trace->phase_seconds[p] += rec->phase_seconds[p];
+        }
+        trace->num_allocs += rec->num_allocs;
+        if (trace->callback != NULL) {
+                trace->callback(trace->context, rec);
+        }
+        pthread_mutex_unlock(&trace->lock);
+}
+size_t ga_trace_count(const ga_trace_t *trace) {
+        return (trace->num_records < trace->capacity) ? trace->num_records
+                                                      : trace->capacity;
+}
+const ga_gen_record_t *ga_trace_get(const ga_trace_t *trace, size_t k) {
+        size_t oldest = trace->num_records - ga_trace_count(trace);
+        return trace->ring + (oldest + k) % trace->capacity;
+}
+const char *ga_phase_name(ga_phase_t phase) {
+        static const char *const names[GA_NUM_PHASES] = {
+                [GA_PHASE_SELECT] = "select",
+                [GA_PHASE_BREED] = "breed",
+                [GA_PHASE_FITNESS] = "fitness",
+                [GA_PHASE_LOCAL_SEARCH] = "local_search",
+                [GA_PHASE_FITTEST] = "fittest",
+                [GA_PHASE_SYNC] = "sync",
+                [GA_PHASE_MIGRATION] = "migration"
+        };
+        return (phase < GA_NUM_PHASES) ? names[phase] : "unknown";
+}
+
+void *ga_malloc(size_t size) {
+        ga_num_allocs++;
+        return malloc(size);
+}
+void *ga_aligned_alloc(size_t alignment, size_t size) {
+        ga_num_allocs++;
+        return aligned_alloc(alignment, size);
+}
+void ga_lap_start(double *phase_seconds, struct timespec *lap) {
+        if (phase_seconds != NULL) {
+                clock_gettime(CLOCK_MONOTONIC, lap);
+        }
+}
+void ga_lap(double *phase_seconds, ga_phase_t phase, struct timespec *lap) {
+        if (phase_seconds == NULL) {
+                return;
+        }
+        phase_seconds[phase] += mono_lap(lap);
+}
+void ga_record_pop(ga_gen_record_t *rec, const pop_arena_t *pop,
+                   const ga_ctx_t *ctx) {
+        long long best = LLONG_MAX;
+        double sum = 0;
+        for (size_t i=0; i<pop->num_chroms; i++) {
+                if (pop->unfitness[i] < best) {
+                        best = pop->unfitness[i];
+                }
+                sum += (double)fitness_key_value(pop->unfitness[i],
+                                                 ctx->key_shift);
+        }
+        rec->best_unfitness = fitness_key_value(best, ctx->key_shift);
+        rec->mean_unfitness = (pop->num_chroms > 0) ? sum / pop->num_chroms
+                                                    : 0;
+        /* pairs half a population apart, spread evenly over it; the
+         * chromosomes are normalized, so a partition and its inverse never
+         * count as distant */
+        size_t n = pop->num_chroms;
+        size_t num_pairs = (n < DIVERSITY_PAIRS) ? n : DIVERSITY_PAIRS;
+        double distance = 0;
+        if (n >= 2 && pop->num_bits > 0) {
+                for (size_t k=0; k<num_pairs; k++) {
+                        size_t i = k * n / num_pairs;
+                        size_t j = (i + n / 2) % n;
+                        distance += words_distance(ARENA_CHROM(pop, i),
+                                                   ARENA_CHROM(pop, j),
+                                                   pop->num_bits);
+                }
+                distance /= (double)num_pairs * pop->num_bits;
+        }
+        rec->diversity = distance;
+}
@@ -0,0 +1,96 @@
+#ifndef GA_TRACE_H
+#define GA_TRACE_H
+/** Header file for the telemetry of genetic algorithm runs: time spent per
+ * phase, population statistics and allocation counts of every generation,
+ * collected while ga_params_t.trace is set and kept in a ring buffer. A run
+ * without a trace only pays for a NULL check per phase
+ * @file ga-trace.h */
+
+#include "number-partition.h"
+#include <pthread.h>
+
+typedef enum ga_phase ga_phase_t;
+/** Phases of a generation that are timed */
+enum ga_phase {
+        /** Tournament selection into the mating pool */
+        GA_PHASE_SELECT,
+        /** Crossover and mutation of the offspring, along with their
+         * evaluation from a parent's difference where it is close enough */
+        GA_PHASE_BREED,
+        /** Evaluation of the other offspring from scratch */
+        GA_PHASE_FITNESS,
+        /** Local search over the fittest offspring */
+        GA_PHASE_LOCAL_SEARCH,
+        /** Finding the fittest offspring and keeping the best so far */
+        GA_PHASE_FITTEST,
+        /** Waiting for the other threads of the population */
+        GA_PHASE_SYNC,
+        /** Exchanging migrants with the neighbouring islands, including
+         * waiting for them */
+        GA_PHASE_MIGRATION,
+        GA_NUM_PHASES
+};
+typedef struct ga_gen_record ga_gen_record_t;
+/** Telemetry of one generation of one population; generation 0 is the
+ * initial population, whose phases are not timed */
+struct ga_gen_record {
+        size_t gen;
+        /** Island of the population; 0 without islands */
+        size_t island;
+        /** Lowest unfitness in the generation, which may be worse than the
+         * best found so far */
+        unsigned __int128 best_unfitness;
+        double mean_unfitness;
+        /** Mean fraction of bits by which sampled pairs of chromosomes
+         * differ; near 0 once the population has converged */
+        double diversity;
+        /** Seconds spent in each phase; for a population shared by several
+         * threads, those of its first thread */
+        double phase_seconds[GA_NUM_PHASES];
+        /** Heap allocations made by the engine during the generation, over
+         * all threads of the population */
+        size_t num_allocs;
+};
+/** Called with every record as soon as it is made */
+typedef void ga_trace_fn_t(void *context, const ga_gen_record_t *rec);
+typedef struct ga_trace ga_trace_t;
+/** Collector of records, shared by every thread and island of a run */
+struct ga_trace {
+        /** Called under the lock of the trace, so never concurrently, if
+         * not NULL */
+        ga_trace_fn_t *callback;
+        void *context;
+        /** Number of records kept */
+        size_t capacity;
+        /** The last min(capacity, num_records) records, oldest at
+         * num_records % capacity once the ring is full */
+        ga_gen_record_t *ring;
+        /** Number of records made since the trace was created or reset */
+        size_t num_records;
+        /** Totals over all records */
+        double phase_seconds[GA_NUM_PHASES];
+        size_t num_allocs;
+        pthread_mutex_t lock;
+};
+
+/** Returns an empty trace keeping the last capacity records (at least 1),
+ * passing each to callback (if not NULL) along with context
+ * @post                trace must be freed (via ga_trace_free) */
+ga_trace_t *ga_trace_malloc(size_t capacity, ga_trace_fn_t *callback,
+                            void *context);
+/** Frees a trace */
+void ga_trace_free(ga_trace_t *trace);
+/** Drops every record and zeroes the totals, e.g. between runs */
+void ga_trace_reset(ga_trace_t *trace);
+/** Adds a copy of rec to the ring and totals of trace and passes it to the
+ * callback; safe to call from several threads */
+void ga_trace_add(ga_trace_t *trace, const ga_gen_record_t *rec);
+/** Returns the number of records kept */
+size_t ga_trace_count(const ga_trace_t *trace);
+/** Returns the k-th oldest record kept
+ * @pre                 k < ga_trace_count(trace) */
+const ga_gen_record_t *ga_trace_get(const ga_trace_t *trace, size_t k);
+/** Returns the name of a phase, e.g. "local_search" */
+const char *ga_phase_name(ga_phase_t phase);
+
+#endif /* !GA_TRACE_H */
@@ -1,94 +1,806 @@
 #include "number-partition.h"
+#include "ga-config.h"
+#include "prob-file.h"
+#include "out-buf.h"
+#include "ga-trace.h"
+#include "mono-clock.h"
+#include "fitness.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <time.h>
 #include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #define NUM_PASSES              100
+/** Most generation records kept per pass for the trace file; the oldest are
+ * dropped beyond that */
+#define TRACE_CAPACITY          65536
 
-long long sum_set(const long long *set_vals, size_t set_count);
-void print_result(const result_t *res);
-void print_set(const long long *set_vals, size_t set_count);
+/** Layouts of the output */
+enum output_format {
+        /** Human-readable lines */
+        OUTPUT_TEXT,
+        /** One JSON object per line: a record per pass, then a summary */
+        OUTPUT_JSONL,
+        /** A header line, then a row per pass */
+        OUTPUT_CSV
+};
+/** Levels of detail of the output */
+enum verbosity {
+        /** Only the averages over all passes */
+        VERBOSITY_SUMMARY,
+        /** Also the generations, sums, difference and time of each pass */
+        VERBOSITY_PASSES,
+        /** Also the values of both sets of each pass */
+        VERBOSITY_SETS
+};
 
-/* Input format:
+/** Settings of the driver, set by option or config file */
+struct settings {
+        ga_params_t params;
+        size_t num_passes;
+        size_t pass_threads;
+        enum output_format format;
+        enum verbosity verbosity;
+        /** Whether passes are traced (ga-trace.h) */
+        bool trace;
+};
+/** Outcome of one pass, filled in by whichever thread ran it */
+struct pass {
+        /** Everything the pass prints, emitted once all earlier passes have
+         * been emitted */
+        out_buf_t output;
+        /** Records of the pass for the trace file, emitted likewise */
+        out_buf_t trace_output;
+        size_t num_gens_passed;
+        unsigned __int128 sum_diff;
+        ga_stats_t stats;
+        /** Telemetry totals of the pass if traced */
+        double phase_seconds[GA_NUM_PHASES];
+        size_t num_allocs;
+        bool done;
+};
+/** Totals over all passes; kept exactly and divided once at the end */
+struct totals {
+        size_t num_gens;
+        unsigned __int128 sum_diff;
+        unsigned __int128 best_sum_diff;
+        ga_stats_t stats;
+        double phase_seconds[GA_NUM_PHASES];
+        size_t num_allocs;
+};
+/** Passes shared out between the threads of the batch */
+struct batch {
+        const prob_set_t *ps;
+        const struct settings *settings;
+        size_t num_passes;
+        struct pass *passes;
+        /** Index of the next pass to be claimed */
+        size_t next_pass;
+        pthread_mutex_t lock;
+        /** Signalled whenever a pass is done */
+        pthread_cond_t pass_done;
+};
+
+/** Setting named by each option that takes a number */
+struct option_key {
+        int opt;
+        const char *key;
+};
+static const struct option_key option_keys[] = {
+        {'m', "mutation_rate"},
+        {'s', "seed"},
+        {'t', "threads"},
+        {'i', "islands"},
+        {'e', "migration_interval"},
+        {'x', "migrants"},
+        {'p', "pass_threads"},
+        {'H', "seed_fraction"},
+        {'L', "local_search_k"},
+        {'B', "local_search_budget"},
+        {'g', "max_gens"},
+        {'k', "tourn_size"},
+        {'n', "passes"}
+};
+
+/** Returns the setting option opt sets, or NULL if it takes no number */
+const char *option_key(int opt);
+/** Prints the usage of the driver, run as prog, on stderr */
+void print_usage(const char *prog);
+/** Sets the setting named key, which is passes, pass_threads, format,
+ * verbosity or any key of ga_params_set; a config_setter_t over struct
+ * settings */
+bool set_setting(void *settings, const char *key, const char *value);
+/** Sets the settings listed in the config file at path, printing the
+ * offending line on failure */
+bool read_config(struct settings *settings, const char *path);
+/** Body of every thread of the batch: claims and runs passes until none are
+ * left */
+void *run_passes(void *batch);
+/** Parses the name of an output format; returns false if there is none
+ * such */
+bool parse_format(const char *name, enum output_format *format);
+/** Appends what the settings print before any pass */
+void print_header(out_buf_t *out, const struct settings *settings);
+/** Appends what the settings print for pass i, which took seconds */
+void print_pass(out_buf_t *out, const struct settings *settings, size_t i,
+                const result_t *res, double seconds);
+/** Appends what the settings print after every pass, given the totals over
+ * the passes */
+void print_summary(out_buf_t *out, const struct settings *settings,
+                   const struct totals *totals);
+/** Appends what the trace file starts with */
+void print_trace_header(out_buf_t *out, const struct settings *settings);
+/** Appends the records kept by the trace of pass i to the trace file */
+void print_trace(out_buf_t *out, const struct settings *settings, size_t i,
+                 const ga_trace_t *trace);
+void print_result(out_buf_t *out, const result_t *res);
+/** Appends the local search counters summed over all passes */
+void print_stats(out_buf_t *out, const ga_stats_t *stats);
+/** Appends the values of set 0 or 1 of a result, separated by sep */
+void print_set(out_buf_t *out, const result_t *res, unsigned set, char sep);
+
+/* Usage: genetic-algorithm.out [-m mutation_rate] [-s seed] [-t threads]
+ *                              [-i islands [-e interval] [-x migrants]]
+ *                              [-p pass_threads] [-f] [-H fraction]
+ *                              [-L offspring [-B seconds]] [-g gens]
+ *                              [-k tourn_size] [-n passes] [-M megabytes]
+ *                              [-C config]
+ *                              [-o key=value] [-F problem_file]
+ *                              [-v verbosity] [-O format] [-T trace_file]
+ *                              < input
+ * -m           probability of flipping each bit during mutation; defaults to
+ *              1/N
+ * -s           seed of the run; defaults to the current time. The seed is
+ *              printed first so any run can be reproduced bit for bit; pass i
+ *              uses random stream i of the seed
+ * -t           number of threads working on each generation; defaults to 1
+ * -i           number of islands, each evolving a sub-population on its own
+ *              thread; defaults to 1 (a single population)
+ * -e           number of generations between migrations; defaults to 10
+ * -x           number of best chromosomes migrating from each island;
+ *              defaults to 2
+ * -p           number of passes run at the same time, each on its own thread;
+ *              defaults to 1. Output is still printed in pass order
+ * -f           evaluate every offspring from scratch rather than from the
+ *              difference of a close parent; the results are the same
+ * -H           fraction of the initial population seeded from the
+ *              differencing method and (randomized) greedy partitions rather
+ *              than drawn at random; defaults to 0
+ * -L           number of fittest offspring of each generation improved by
+ *              local search (single moves and swaps of items between the
+ *              sets); defaults to 0. Its counters are printed at the end.
+ *              Ignored, with a warning, if the sums of the items exceed the
+ *              range of a long long
+ * -B           seconds of local search allowed per generation and thread or
+ *              island; defaults to no limit. Runs cut short by it are not
+ *              reproducible
+ * -g           max number of generations per pass; defaults to 100
+ * -k           number of chromosomes per tournament; defaults to 2
+ * -n           number of passes; defaults to 100
+ * -M           memory budget of the populations of each pass, in MiB;
+ *              defaults to none. The population shrinks to fit it, and an
+ *              instance too large for that is first reduced by the
+ *              differencing method to as many partial partitions as fit,
+ *              which the search then partitions
+ * -C           reads settings from a file of "key = value" lines, '#'
+ *              starting a comment. Keys are passes, pass_threads, format,
+ *              verbosity and those of ga_params_set (ga-config.h), which
+ *              also include pop_size_factor, pop_size_cap, reduce_items,
+ *              crossover, replacement, target_diff, stall_gens and
+ *              time_limit. Options and files are applied in order, so
+ *              later ones override earlier ones
+ * -o           sets a single key as in a config file
+ * -F           maps a binary problem file (prob-convert.out writes them)
+ *              instead of reading stdin, using its sorted index rather than
+ *              sorting the items again
+ * -v           level of detail: 0 prints only the averages over all passes,
+ *              1 also the generations, set sums, difference and seconds of
+ *              each pass and 2 also the values of both sets; defaults to 2
+ * -O           text, jsonl or csv; defaults to text. jsonl prints a JSON
+ *              object per pass ("type":"pass", with the sets as arrays at
+ *              verbosity 2) and then a "type":"summary" one, csv a header
+ *              and a row per pass whatever the verbosity, each record
+ *              carrying the seed
+ * -T           writes a record per generation (and island) of every pass to
+ *              trace_file: the best and mean unfitness, the diversity of the
+ *              population, the allocations made and the seconds spent in
+ *              each phase. It is in JSON lines under -O jsonl and CSV
+ *              otherwise. The summary then also totals the phases
+ *
+ * Input format:
  * N
  * x_1, x_2, x_3, . . . x_N-1
  * N = number of items/values to partition
  * x_i = i-th element's value */
-int main(void) {
-        srand(time(NULL));
-        size_t num_items;
-        scanf(" %zu", &num_items);
-        prob_set_t *ps = prob_set_malloc(num_items);
-        for (size_t i=0; i<num_items; i++) {
-                scanf(" %lld", ps->item_vals+i);
-        }
-        long double avg_gen = 0;
-        long double avg_sum_diff = 0;
-        long long best_sum_diff = LLONG_MAX;
-        for (size_t i=0; i<NUM_PASSES; i++) {
-                printf("pass #%zu:\n", i);
-                result_t *res = num_part_2way(ps);
-                print_result(res);
-                avg_gen = avg_gen / (i+1) * i
-                          + (long double)res->num_gens_passed / (i+1);
-                long long set0_sum = sum_set(res->set0_vals, res->set0_count);
-                long long set1_sum = sum_set(res->set1_vals, res->set1_count);
-                long long sum_diff;
-                if (set1_sum < set0_sum) {
-                        sum_diff = set0_sum - set1_sum;
-                } else {
-                        sum_diff = set1_sum - set0_sum;
-                }
-                if (sum_diff < best_sum_diff) {
-                        best_sum_diff = sum_diff;
-                }
-                avg_sum_diff = avg_sum_diff / (i+1) * i
-                               + (long double)sum_diff / (i+1);
+int main(int argc, char **argv) {
+        struct settings settings = {.num_passes = NUM_PASSES,
+                                    .pass_threads = 1,
+                                    .format = OUTPUT_TEXT,
+                                    .verbosity = VERBOSITY_SETS};
+        const char *prob_path = NULL;
+        const char *trace_path = NULL;
+        ga_params_t *params = &settings.params;
+        ga_params_init(params);
+        params->seed = time(NULL);
+        int opt;
+        const char *optstring = "m:s:t:i:e:x:p:fH:L:B:g:k:n:M:C:o:F:v:O:T:";
+        while ((opt = getopt(argc, argv, optstring)) != -1) {
+                char *equals;
+                double megabytes;
+                switch (opt) {
+                case 'f':
+                        params->delta_fitness = false;
+                        break;
+                case 'M':
+                        /* given in MiB, kept in bytes */
+                        if (!config_parse_double(optarg, &megabytes)
+                            || megabytes >= SIZE_MAX / (1 << 20)) {
+                                fprintf(stderr, "bad -M: %s\n", optarg);
+                                print_usage(argv[0]);
+                                return 1;
+                        }
+                        params->memory_budget = (size_t)(megabytes
+                                                         * (1 << 20));
+                        break;
+                case 'C':
+                        if (!read_config(&settings, optarg)) {
+                                return 1;
+                        }
+                        break;
+                case 'F':
+                        prob_path = optarg;
+                        break;
+                case 'T':
+                        trace_path = optarg;
+                        break;
+                case 'v':
+                case 'O':
+                        if (!set_setting(&settings, (opt == 'v')
+                                                    ? "verbosity" : "format",
+                                         optarg)) {
+                                fprintf(stderr, "bad -%c: %s\n", opt,
+                                        optarg);
+                                print_usage(argv[0]);
+                                return 1;
+                        }
+                        break;
+                case 'o':
+                        equals = strchr(optarg, '=');
+                        if (equals == NULL) {
+                                fprintf(stderr, "-o takes key=value\n");
+                                return 1;
+                        }
+                        *equals = '\0';
+                        if (!set_setting(&settings, optarg, equals + 1)) {
+                                fprintf(stderr, "bad setting: %s=%s\n",
+                                        optarg, equals + 1);
+                                return 1;
+                        }
+                        break;
+                default:
+                        if (option_key(opt) == NULL) {
+                                print_usage(argv[0]);
+                                return 1;
+                        }
+                        if (!set_setting(&settings, option_key(opt),
+                                         optarg)) {
+                                fprintf(stderr, "bad -%c: %s\n", opt,
+                                        optarg);
+                                print_usage(argv[0]);
+                                return 1;
+                        }
+                        break;
+                }
+        }
+        FILE *trace_file = NULL;
+        if (trace_path != NULL) {
+                trace_file = fopen(trace_path, "w");
+                if (trace_file == NULL) {
+                        perror(trace_path);
+                        return 1;
+                }
+                settings.trace = true;
+        }
+        out_buf_t out;
+        out_buf_init(&out);
+        print_header(&out, &settings);
+        out_buf_flush(&out, stdout);
+        if (trace_file != NULL) {
+                print_trace_header(&out, &settings);
+                out_buf_flush(&out, trace_file);
+        }
+        prob_io_status_t status;
+        prob_set_t *read_ps = NULL;
+        prob_file_t *pf = NULL;
+        const prob_set_t *ps;
+        if (prob_path != NULL) {
+                pf = prob_file_map(prob_path, false, &status);
+                ps = (pf != NULL) ? pf->ps : NULL;
+        } else {
+                read_ps = prob_set_read(stdin, &status);
+                ps = read_ps;
+        }
+        if (ps == NULL) {
+                fprintf(stderr, "bad input: %s\n", prob_io_strerror(status));
+                return 1;
+        }
+        if (pf != NULL) {
+                params->sorted = pf->sorted;
+        }
+        if (params->local_search_k > 0
+            && fitness_width(ps->item_vals, ps->num_items) == FITNESS_WIDE) {
+                fprintf(stderr, "warning: -L ignored: the item sums exceed "
+                        "the range of a long long\n");
+        }
+        size_t num_passes = settings.num_passes;
+        size_t pass_threads = settings.pass_threads;
+        if (num_passes == 0) {
+                num_passes = 1;
+        }
+        if (pass_threads == 0) {
+                pass_threads = 1;
+        }
+        struct batch *batch = malloc(sizeof(*batch));
+        batch->ps = ps;
+        batch->settings = &settings;
+        batch->next_pass = 0;
+        batch->num_passes = num_passes;
+        batch->passes = malloc(sizeof(*batch->passes) * num_passes);
+        for (size_t i=0; i<num_passes; i++) {
+                out_buf_init(&batch->passes[i].output);
+                out_buf_init(&batch->passes[i].trace_output);
+                batch->passes[i].done = false;
+        }
+        pthread_mutex_init(&batch->lock, NULL);
+        pthread_cond_init(&batch->pass_done, NULL);
+        pthread_t *threads = malloc(sizeof(*threads) * pass_threads);
+        for (size_t t=0; t<pass_threads; t++) {
+                pthread_create(threads+t, NULL, run_passes, batch);
+        }
+        /* every pass's difference fits even when the sums of the sets do
+         * not */
+        struct totals totals = {.best_sum_diff = ~(unsigned __int128)0};
+        /* passes are emitted and averaged in order no matter which finishes
+         * first, so the output only depends on the seed */
+        for (size_t i=0; i<num_passes; i++) {
+                struct pass *pass = batch->passes + i;
+                pthread_mutex_lock(&batch->lock);
+                while (!pass->done) {
+                        pthread_cond_wait(&batch->pass_done, &batch->lock);
+                }
+                pthread_mutex_unlock(&batch->lock);
+                out_buf_flush(&pass->output, stdout);
+                out_buf_free(&pass->output);
+                if (trace_file != NULL) {
+                        out_buf_flush(&pass->trace_output, trace_file);
+                }
+                out_buf_free(&pass->trace_output);
+                totals.num_gens += pass->num_gens_passed;
+                if (pass->sum_diff < totals.best_sum_diff) {
+                        totals.best_sum_diff = pass->sum_diff;
+                }
+                totals.sum_diff += pass->sum_diff;
+                ga_stats_add(&totals.stats, &pass->stats);
+                if (settings.trace) {
+                        for (size_t p=0; p<GA_NUM_PHASES; p++) {
+                                totals.phase_seconds[p]
+                                        += pass->phase_seconds[p];
+                        }
+                        totals.num_allocs += pass->num_allocs;
+                }
+        }
+        for (size_t t=0; t<pass_threads; t++) {
+                pthread_join(threads[t], NULL);
+        }
+        free(threads);
+        pthread_cond_destroy(&batch->pass_done);
+        pthread_mutex_destroy(&batch->lock);
+        free(batch->passes);
+        free(batch);
+        settings.num_passes = num_passes;
+        print_summary(&out, &settings, &totals);
+        out_buf_flush(&out, stdout);
+        out_buf_free(&out);
+        int ret = 0;
+        if (trace_file != NULL && fclose(trace_file) != 0) {
+                perror(trace_path);
+                ret = 1;
+        }
+        if (pf != NULL) {
+                prob_file_unmap(pf);
+        } else {
+                prob_set_free(read_ps);
+        }
+        return ret;
+}
+
+bool set_setting(void *settings_ptr, const char *key, const char *value) {
+        struct settings *settings = (struct settings *)settings_ptr;
+        size_t *field = NULL;
+        if (strcmp(key, "passes") == 0) {
+                field = &settings->num_passes;
+        } else if (strcmp(key, "pass_threads") == 0) {
+                field = &settings->pass_threads;
+        } else if (strcmp(key, "format") == 0) {
+                return parse_format(value, &settings->format);
+        } else if (strcmp(key, "verbosity") != 0) {
+                return ga_params_set(&settings->params, key, value);
+        }
+        unsigned long long val;
+        if (!config_parse_ull(value, &val) || val > SIZE_MAX) {
+                return false;
+        }
+        if (field == NULL) {
+                if (val > VERBOSITY_SETS) {
+                        return false;
+                }
+                settings->verbosity = (enum verbosity)val;
+                return true;
+        }
+        *field = val;
+        return true;
+}
+const char *option_key(int opt) {
+        for (size_t k=0; k<sizeof(option_keys)/sizeof(*option_keys); k++) {
+                if (option_keys[k].opt == opt) {
+                        return option_keys[k].key;
+                }
+        }
+        return NULL;
+}
+void print_usage(const char *prog) {
+        fprintf(stderr, "usage: %s [-m mutation_rate] "
+                "[-s seed] [-t threads] [-i islands "
+                "[-e interval] [-x migrants]] "
+                "[-p pass_threads] [-f] [-H fraction] "
+                "[-L offspring [-B seconds]] [-g gens] "
+                "[-k tourn_size] [-n passes] "
+                "[-M megabytes] [-C config] "
+                "[-o key=value] [-F problem_file] "
+                "[-v verbosity] [-O format] "
+                "[-T trace_file]\n",
+                prog);
+}
+bool read_config(struct settings *settings, const char *path) {
+        FILE *in = fopen(path, "r");
+        if (in == NULL) {
+                perror(path);
+                return false;
+        }
+        size_t bad_line = config_read(in, set_setting, settings);
+        fclose(in);
+        if (bad_line != 0) {
+                fprintf(stderr, "%s:%zu: bad setting\n", path, bad_line);
+                return false;
+        }
+        return true;
+}
+void *run_passes(void *batch_ptr) {
+        struct batch *batch = (struct batch *)batch_ptr;
+        const struct settings *settings = batch->settings;
+        ga_params_t params = settings->params;
+        /* each thread reuses one trace for all its passes; a record per
+         * generation of each island fits */
+        if (settings->trace) {
+                size_t num_islands = (params.num_islands > 1)
+                                     ? params.num_islands
+                                     : 1;
+                size_t capacity = TRACE_CAPACITY / num_islands;
+                if (params.max_gens < capacity) {
+                        capacity = params.max_gens;
+                }
+                params.trace = ga_trace_malloc(capacity * num_islands, NULL,
+                                               NULL);
+        }
+        while (true) {
+                pthread_mutex_lock(&batch->lock);
+                size_t i = batch->next_pass++;
+                pthread_mutex_unlock(&batch->lock);
+                if (i >= batch->num_passes) {
+                        break;
+                }
+                struct pass *pass = batch->passes + i;
+                params.stream = i;
+                if (params.trace != NULL) {
+                        ga_trace_reset(params.trace);
+                }
+                double start = mono_now();
+                result_t *res = num_part_2way_stats(batch->ps, &params,
+                                                    &pass->stats);
+                print_pass(&pass->output, settings, i, res,
+                           mono_now() - start);
+                if (params.trace != NULL) {
+                        print_trace(&pass->trace_output, settings, i,
+                                    params.trace);
+                        for (size_t p=0; p<GA_NUM_PHASES; p++) {
+                                pass->phase_seconds[p]
+                                        = params.trace->phase_seconds[p];
+                        }
+                        pass->num_allocs = params.trace->num_allocs;
+                }
+                pass->sum_diff = result_diff(res);
+                pass->num_gens_passed = res->num_gens_passed;
                 result_free(res);
-                putchar('\n');
-        }
-        printf("average number of generations passed = %Lf\n"
-               "average sum difference = %Lf\n"
-               "best sum difference = %lld\n",
-               avg_gen, avg_sum_diff, best_sum_diff);
-        prob_set_free(ps);
-        return 0;
+                pthread_mutex_lock(&batch->lock);
+                pass->done = true;
+                pthread_cond_broadcast(&batch->pass_done);
+                pthread_mutex_unlock(&batch->lock);
+        }
+        if (params.trace != NULL) {
+                ga_trace_free(params.trace);
+        }
+        return NULL;
 }
 
-long long sum_set(const long long *set_vals, size_t set_count) {
-        long long sum = 0;
-        for (size_t i=0; i<set_count; i++) {
-                sum += set_vals[i];
+bool parse_format(const char *name, enum output_format *format) {
+        static const char *const names[] = {
+                [OUTPUT_TEXT] = "text",
+                [OUTPUT_JSONL] = "jsonl",
+                [OUTPUT_CSV] = "csv"
+        };
+        for (size_t i=0; i<sizeof(names) / sizeof(*names); i++) {
+                if (strcmp(name, names[i]) == 0) {
+                        *format = (enum output_format)i;
+                        return true;
+                }
         }
-        return sum;
+        return false;
 }
-void print_result(const result_t *res) {
-        printf("# generations passed: %zu\n"
-               "# items in set0: %zu\n"
-               "set0 item values:\n",
-               res->num_gens_passed, res->set0_count);
-        print_set(res->set0_vals, res->set0_count);
-        long long set0_sum = sum_set(res->set0_vals, res->set0_count);
-        printf("set0 sum: %lld\n", set0_sum);
-        printf("# items in set1: %zu\n"
-               "set1 item values:\n",
-               res->set1_count);
-        print_set(res->set1_vals, res->set1_count);
-        long long set1_sum = sum_set(res->set1_vals, res->set1_count);
-        printf("set1 sum: %lld\n", set1_sum);
-        unsigned long long sum_diff;
-        if (set1_sum > set0_sum) {
-                sum_diff = set1_sum - set0_sum;
-        } else {
-                sum_diff = set0_sum - set1_sum;
+void print_header(out_buf_t *out, const struct settings *settings) {
+        switch (settings->format) {
+        case OUTPUT_TEXT:
+                out_buf_str(out, "seed: ");
+                out_buf_ull(out, settings->params.seed);
+                out_buf_str(out, "\n\n");
+                break;
+        case OUTPUT_JSONL:
+                break;
+        case OUTPUT_CSV:
+                out_buf_str(out, "seed,pass,generations,set0_count,"
+                            "set1_count,set0_sum,set1_sum,difference,"
+                            "seconds\n");
+                break;
+        }
+}
+void print_pass(out_buf_t *out, const struct settings *settings, size_t i,
+                const result_t *res, double seconds) {
+        if (settings->verbosity == VERBOSITY_SUMMARY
+            && settings->format != OUTPUT_CSV) {
+                return;
+        }
+        switch (settings->format) {
+        case OUTPUT_TEXT:
+                out_buf_str(out, "pass #");
+                out_buf_ull(out, i);
+                if (settings->verbosity == VERBOSITY_SETS) {
+                        out_buf_str(out, ":\n");
+                        print_result(out, res);
+                        out_buf_char(out, '\n');
+                        break;
+                }
+                out_buf_str(out, ": generations passed: ");
+                out_buf_ull(out, res->num_gens_passed);
+                out_buf_str(out, ", set0 sum: ");
+                out_buf_int128(out, res->set0_sum);
+                out_buf_str(out, ", set1 sum: ");
+                out_buf_int128(out, res->set1_sum);
+                out_buf_str(out, ", difference of sums: ");
+                out_buf_uint128(out, result_diff(res));
+                out_buf_printf(out, ", seconds: %f\n", seconds);
+                break;
+        case OUTPUT_JSONL:
+                out_buf_str(out, "{\"type\":\"pass\",\"seed\":");
+                out_buf_ull(out, settings->params.seed);
+                out_buf_str(out, ",\"pass\":");
+                out_buf_ull(out, i);
+                out_buf_str(out, ",\"generations\":");
+                out_buf_ull(out, res->num_gens_passed);
+                out_buf_str(out, ",\"set0_count\":");
+                out_buf_ull(out, res->set0_count);
+                out_buf_str(out, ",\"set1_count\":");
+                out_buf_ull(out, res->set1_count);
+                out_buf_str(out, ",\"set0_sum\":");
+                out_buf_int128(out, res->set0_sum);
+                out_buf_str(out, ",\"set1_sum\":");
+                out_buf_int128(out, res->set1_sum);
+                out_buf_str(out, ",\"difference\":");
+                out_buf_uint128(out, result_diff(res));
+                out_buf_printf(out, ",\"seconds\":%f", seconds);
+                if (settings->verbosity == VERBOSITY_SETS) {
+                        out_buf_str(out, ",\"set0\":[");
+                        print_set(out, res, 0, ',');
+                        out_buf_str(out, "],\"set1\":[");
+                        print_set(out, res, 1, ',');
+                        out_buf_char(out, ']');
+                }
+                out_buf_str(out, "}\n");
+                break;
+        case OUTPUT_CSV:
+                out_buf_ull(out, settings->params.seed);
+                out_buf_char(out, ',');
+                out_buf_ull(out, i);
+                out_buf_char(out, ',');
+                out_buf_ull(out, res->num_gens_passed);
+                out_buf_char(out, ',');
+                out_buf_ull(out, res->set0_count);
+                out_buf_char(out, ',');
+                out_buf_ull(out, res->set1_count);
+                out_buf_char(out, ',');
+                out_buf_int128(out, res->set0_sum);
+                out_buf_char(out, ',');
+                out_buf_int128(out, res->set1_sum);
+                out_buf_char(out, ',');
+                out_buf_uint128(out, result_diff(res));
+                out_buf_printf(out, ",%f\n", seconds);
+                break;
         }
-        printf("difference of sums: %llu\n", sum_diff);
 }
-void print_set(const long long *set_vals, size_t set_count) {
-        for (size_t i=0; i<set_count; i++) {
-                printf("%lld ", set_vals[i]);
+void print_summary(out_buf_t *out, const struct settings *settings,
+                   const struct totals *totals) {
+        size_t num_passes = settings->num_passes;
+        const ga_stats_t *stats = &totals->stats;
+        bool has_ls = settings->params.local_search_k > 0;
+        switch (settings->format) {
+        case OUTPUT_TEXT:
+                out_buf_printf(out, "average number of generations passed "
+                               "= %Lf\n"
+                               "average sum difference = %Lf\n"
+                               "best sum difference = ",
+                               (long double)totals->num_gens / num_passes,
+                               (long double)totals->sum_diff / num_passes);
+                out_buf_uint128(out, totals->best_sum_diff);
+                out_buf_char(out, '\n');
+                if (has_ls) {
+                        print_stats(out, stats);
+                }
+                if (settings->trace) {
+                        out_buf_str(out, "seconds per phase:");
+                        for (size_t p=0; p<GA_NUM_PHASES; p++) {
+                                out_buf_printf(out, "%s %s %f",
+                                               (p > 0) ? "," : "",
+                                               ga_phase_name(p),
+                                               totals->phase_seconds[p]);
+                        }
+                        out_buf_str(out, "\nallocations during the search = ");
+                        out_buf_ull(out, totals->num_allocs);
+                        out_buf_char(out, '\n');
+                }
+                break;
+        case OUTPUT_JSONL:
+                out_buf_str(out, "{\"type\":\"summary\",\"seed\":");
+                out_buf_ull(out, settings->params.seed);
+                out_buf_str(out, ",\"passes\":");
+                out_buf_ull(out, num_passes);
+                out_buf_printf(out, ",\"average_generations\":%Lf"
+                               ",\"average_difference\":%Lf",
+                               (long double)totals->num_gens / num_passes,
+                               (long double)totals->sum_diff / num_passes);
+                out_buf_str(out, ",\"best_difference\":");
+                out_buf_uint128(out, totals->best_sum_diff);
+                if (has_ls) {
+                        out_buf_printf(out, ",\"ls_offspring\":%zu"
+                                       ",\"ls_improved\":%zu"
+                                       ",\"ls_moves\":%zu"
+                                       ",\"ls_swaps\":%zu"
+                                       ",\"ls_average_gain\":%f"
+                                       ",\"ls_budget_hits\":%zu"
+                                       ",\"ls_seconds\":%f",
+                                       stats->ls_chroms, stats->ls_improved,
+                                       stats->ls_moves, stats->ls_swaps,
+                                       (stats->ls_chroms > 0)
+                                       ? stats->ls_gain / stats->ls_chroms
+                                       : 0.0,
+                                       stats->ls_budget_hits,
+                                       stats->ls_seconds);
+                }
+                if (settings->trace) {
+                        for (size_t p=0; p<GA_NUM_PHASES; p++) {
+                                out_buf_printf(out, ",\"%s_seconds\":%f",
+                                               ga_phase_name(p),
+                                               totals->phase_seconds[p]);
+                        }
+                        out_buf_str(out, ",\"allocations\":");
+                        out_buf_ull(out, totals->num_allocs);
+                }
+                out_buf_str(out, "}\n");
+                break;
+        case OUTPUT_CSV:
+                break;
+        }
+}
+void print_trace_header(out_buf_t *out, const struct settings *settings) {
+        if (settings->format == OUTPUT_JSONL) {
+                return;
+        }
+        out_buf_str(out, "pass,island,generation,best_unfitness,"
+                    "mean_unfitness,diversity,allocations");
+        for (size_t p=0; p<GA_NUM_PHASES; p++) {
+                out_buf_printf(out, ",%s_seconds", ga_phase_name(p));
+        }
+        out_buf_char(out, '\n');
+}
+void print_trace(out_buf_t *out, const struct settings *settings, size_t i,
+                 const ga_trace_t *trace) {
+        bool jsonl = settings->format == OUTPUT_JSONL;
+        for (size_t k=0; k<ga_trace_count(trace); k++) {
+                const ga_gen_record_t *rec = ga_trace_get(trace, k);
+                out_buf_str(out, jsonl ? "{\"pass\":" : "");
+                out_buf_ull(out, i);
+                out_buf_str(out, jsonl ? ",\"island\":" : ",");
+                out_buf_ull(out, rec->island);
+                out_buf_str(out, jsonl ? ",\"generation\":" : ",");
+                out_buf_ull(out, rec->gen);
+                out_buf_str(out, jsonl ? ",\"best_unfitness\":" : ",");
+                out_buf_uint128(out, rec->best_unfitness);
+                out_buf_printf(out, jsonl ? ",\"mean_unfitness\":%f"
+                                            ",\"diversity\":%f"
+                                          : ",%f,%f",
+                               rec->mean_unfitness, rec->diversity);
+                out_buf_str(out, jsonl ? ",\"allocations\":" : ",");
+                out_buf_ull(out, rec->num_allocs);
+                for (size_t p=0; p<GA_NUM_PHASES; p++) {
+                        if (jsonl) {
+                                out_buf_printf(out, ",\"%s_seconds\":%.9f",
+                                               ga_phase_name(p),
+                                               rec->phase_seconds[p]);
+                        } else {
+                                out_buf_printf(out, ",%.9f",
+                                               rec->phase_seconds[p]);
+                        }
+                }
+                out_buf_str(out, jsonl ? "}\n" : "\n");
+        }
+}
+void print_result(out_buf_t *out, const result_t *res) {
+        out_buf_str(out, "# generations passed: ");
+        out_buf_ull(out, res->num_gens_passed);
+        out_buf_str(out, "\n# items in set0: ");
+        out_buf_ull(out, res->set0_count);
+        out_buf_str(out, "\nset0 item values:\n");
+        print_set(out, res, 0, ' ');
+        /* the text format ends every value with a space */
+        out_buf_str(out, (res->set0_count > 0) ? " \nset0 sum: "
+                                                : "\nset0 sum: ");
+        out_buf_int128(out, res->set0_sum);
+        out_buf_str(out, "\n# items in set1: ");
+        out_buf_ull(out, res->set1_count);
+        out_buf_str(out, "\nset1 item values:\n");
+        print_set(out, res, 1, ' ');
+        out_buf_str(out, (res->set1_count > 0) ? " \nset1 sum: "
+                                                : "\nset1 sum: ");
+        out_buf_int128(out, res->set1_sum);
+        out_buf_str(out, "\ndifference of sums: ");
+        out_buf_uint128(out, result_diff(res));
+        out_buf_char(out, '\n');
+}
+void print_stats(out_buf_t *out, const ga_stats_t *stats) {
+        out_buf_printf(out, "local search: %zu of %zu offspring improved, "
+                       "%zu moves, %zu swaps\n"
+                       "local search average gain per offspring = %f\n"
+                       "local search budget hits = %zu, seconds = %f\n",
+                       stats->ls_improved, stats->ls_chroms,
+                       stats->ls_moves, stats->ls_swaps,
+                       (stats->ls_chroms > 0)
+                       ? stats->ls_gain / stats->ls_chroms : 0.0,
+                       stats->ls_budget_hits, stats->ls_seconds);
+}
+void print_set(out_buf_t *out, const result_t *res, unsigned set, char sep) {
+        size_t count = (set == 0) ? res->set0_count : res->set1_count;
+        /* a long long takes at most 20 characters, plus the separator */
+        out_buf_reserve(out, count * 21);
+        result_iter_t it;
+        result_iter_init(&it, res, set);
+        long long val;
+        bool first = true;
+        while (result_iter_next(&it, &val)) {
+                if (!first) {
+                        out_buf_char(out, sep);
+                }
+                out_buf_ll(out, val);
+                first = false;
         }
-        putchar('\n');
 }
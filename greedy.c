@@ -1,3 +1,5 @@
+#include "prob-io.h"
+#include "out-buf.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -9,7 +11,8 @@ struct setnode {
 typedef struct setlist setlist_t;
 struct setlist {
         setnode_t *head;
-        long long sum;
+        /* exact even when the items add up past a long long */
+        __int128 sum;
 };
 setlist_t *setlist_malloc(void);
 void setlist_push(setlist_t *sl, long long item_val);
@@ -25,12 +28,13 @@ struct llarray {
 int llong_dsc_cmp(const void *a, const void *b);
 
 int main(void) {
-        llarray_t items;
-        scanf(" %zu", &items.count);
-        items.elems = malloc(items.count*sizeof(*items.elems));
-        for (size_t i=0; i<items.count; i++) {
-                scanf(" %lld", items.elems+i);
+        prob_io_status_t status;
+        prob_set_t *ps = prob_set_read(stdin, &status);
+        if (ps == NULL) {
+                fprintf(stderr, "bad input: %s\n", prob_io_strerror(status));
+                return 1;
         }
+        llarray_t items = {ps->num_items, ps->item_vals};
         qsort(items.elems, items.count, sizeof(*items.elems), llong_dsc_cmp);
         setlist_t *set0 = setlist_malloc();
         setlist_t *set1 = setlist_malloc();
@@ -45,12 +49,14 @@ int main(void) {
         setlist_print(set0);
         printf("set1:\n");
         setlist_print(set1);
-        printf("sum diff = %lld\n", (set0->sum < set1->sum)
-                                    ? set1->sum - set0->sum
-                                    : set0->sum - set1->sum);
+        printf("sum diff = ");
+        fprint_int128(stdout, (set0->sum < set1->sum)
+                              ? set1->sum - set0->sum
+                              : set0->sum - set1->sum);
+        putchar('\n');
         setlist_free(set0);
         setlist_free(set1);
-        free(items.elems);
+        prob_set_free(ps);
         return 0;
 }
 
@@ -78,9 +84,9 @@ void setlist_free(setlist_t *sl) {
         free(sl);
 }
 void setlist_print(const setlist_t *sl) {
-        printf("set sum: %lld\n"
-               "set items:\n",
-               sl->sum);
+        printf("set sum: ");
+        fprint_int128(stdout, sl->sum);
+        printf("\nset items:\n");
         setnode_t tmp;
         tmp.next = sl->head;
         while (tmp.next != NULL) {
@@ -0,0 +1,423 @@
+/** Implements the island model declared in ga-engine.h: every island evolves
+ * its own sub-population on its own thread and, every migration_interval
+ * generations, sends copies of its best chromosomes to the next island of a
+ * ring, where they replace the worst chromosomes. An island that reaches the
+ * target difference stops at once; the others stop at the next migration
+ * boundary, once every island has got there, so the generation they stop at
+ * does not depend on timing
+ * @file island.c */
+#include "ga-engine.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+/** Size of a cache line; producer and consumer indices are kept on separate
+ * lines */
+#define CACHE_LINE              64
+/** Smallest sub-population an island is given */
+#define MIN_ISLAND_SIZE         2
+
+/** Single-producer single-consumer ring of migrant chromosomes; the slots
+ * are only written by the producer and the indices only advance, so no lock
+ * is needed */
+struct migration_ring {
+        /** Number of slots */
+        size_t capacity;
+        /** Number of words per slot */
+        size_t stride;
+        uint64_t *words;
+        long long *diff;
+        /** Producer has exited and will send nothing more */
+        atomic_bool closed;
+        /** Consumer has exited and will read nothing more */
+        atomic_bool abandoned;
+        /** Next slot to read; only written by the consumer */
+        _Alignas(CACHE_LINE) atomic_size_t head;
+        /** Next slot to write; only written by the producer */
+        _Alignas(CACHE_LINE) atomic_size_t tail;
+};
+/** State shared by all islands */
+struct island_run {
+        const prob_set_t *ps;
+        const ga_ctx_t *ctx;
+        size_t migration_interval;
+        size_t num_migrants;
+        struct island *islands;
+        size_t num_islands;
+};
+/** State of one island */
+struct island {
+        struct island_run *run;
+        /** Position of the island in the ring */
+        size_t index;
+        /** Current and next generation; which is which alternates */
+        pop_arena_t *arenas[2];
+        /** Mating pool of indices into the current generation */
+        size_t *pool;
+        /** Scratch space for the indices of the best or worst chromosomes */
+        size_t *picked;
+        /** Ring of migrants sent by the previous island */
+        struct migration_ring *in;
+        /** Ring of migrants sent to the next island */
+        struct migration_ring *out;
+        chrom_t *best_chrom;
+        size_t num_gens_passed;
+        /** Generations passed as of the island's last migration boundary;
+         * SIZE_MAX once it has exited */
+        atomic_size_t progress;
+        /** Generation at which the island reached the target difference, or
+         * SIZE_MAX; published by the release of progress */
+        size_t reached_gen;
+        ga_stats_t stats;
+        pthread_t thread;
+        rng_t rng;
+};
+
+/** Returns a ring with room for capacity chromosomes of num_bits bits */
+static struct migration_ring *ring_malloc(size_t capacity, size_t num_bits);
+/** Frees a ring along with its slots */
+static void ring_free(struct migration_ring *ring);
+/** Copies the fittest chromosome of pop into the island's best if it beats
+ * it */
+static void track_best(struct island *island, const pop_arena_t *pop);
+/** Completes rec with generation gen of the island, whose population is pop
+ * and which started with num_allocs allocations made on the island's
+ * thread, adds it to the trace of the run and clears its timers */
+static void record_gen(const struct island *island, ga_gen_record_t *rec,
+                       size_t gen, const pop_arena_t *pop,
+                       size_t num_allocs);
+/** Body of every island's thread */
+static void *run_island(void *island);
+/** Fills picked with the indices of the num_picked fittest (or, if worst is
+ * set, least fit) chromosomes of pop */
+static void pick_extremes(const pop_arena_t *pop, size_t *picked,
+                          size_t num_picked, bool worst);
+/** Sends copies of the island's best chromosomes to the next island, then
+ * replaces its worst chromosomes with those sent by the previous island */
+static void migrate(struct island *island, pop_arena_t *pop);
+/** Publishes that the island has passed num_gens_passed generations, waits
+ * until every other island has passed as many or exited, and returns
+ * whether any island, itself included, reached the target difference by
+ * then */
+static bool others_reached(struct island *island, size_t num_gens_passed);
+
+result_t *num_part_2way_islands(const prob_set_t *ps,
+                                const ga_params_t *params,
+                                const ga_ctx_t *ctx, ga_stats_t *stats) {
+        const size_t num_islands = params->num_islands;
+        size_t island_size = ctx->pop_size / num_islands;
+        if (island_size < MIN_ISLAND_SIZE) {
+                island_size = MIN_ISLAND_SIZE;
+        }
+        size_t num_migrants = params->num_migrants;
+        if (num_migrants > island_size / 2) {
+                num_migrants = island_size / 2;
+        }
+        struct island_run run = {
+                .ps = ps,
+                .ctx = ctx,
+                .migration_interval = (params->migration_interval > 0)
+                                      ? params->migration_interval
+                                      : 1,
+                .num_migrants = num_migrants,
+                .num_islands = num_islands
+        };
+        struct island *islands = ga_malloc(sizeof(*islands) * num_islands);
+        run.islands = islands;
+        /* ring i carries migrants from island i to island i+1; each ring
+         * holds two migrations so that a producer one interval ahead of
+         * its consumer does not block */
+        struct migration_ring **rings = ga_malloc(sizeof(*rings)
+                                                  * num_islands);
+        for (size_t i=0; i<num_islands; i++) {
+                rings[i] = ring_malloc(2 * num_migrants, ps->num_items);
+        }
+        /* island i uses the i-th jump of the run's stream, as threads do in
+         * the single population engine */
+        rng_t rng;
+        rng_seed_stream(&rng, params->seed, params->stream);
+        for (size_t i=0; i<num_islands; i++) {
+                struct island *island = islands + i;
+                island->run = &run;
+                island->index = i;
+                island->arenas[0] = pop_arena_malloc(island_size,
+                                                     ps->num_items);
+                island->arenas[1] = pop_arena_malloc(island_size,
+                                                     ps->num_items);
+                island->pool = ga_malloc(sizeof(size_t) * island_size);
+                island->picked = ga_malloc(sizeof(size_t)
+                                           * (num_migrants + 1));
+                island->in = rings[(i + num_islands - 1) % num_islands];
+                island->out = rings[i];
+                island->best_chrom = chrom_malloc(ps->num_items);
+                island->best_chrom->unfitness = LLONG_MAX;
+                atomic_init(&island->progress, 0);
+                island->reached_gen = SIZE_MAX;
+                island->stats = (ga_stats_t){0};
+                island->rng = rng;
+                rng_jump(&rng);
+        }
+        for (size_t i=0; i<num_islands; i++) {
+                pthread_create(&islands[i].thread, NULL, run_island,
+                               islands + i);
+        }
+        /* ties go to the lowest island so the outcome does not depend on
+         * timing */
+        size_t best_i = 0;
+        size_t num_gens_passed = 0;
+        for (size_t i=0; i<num_islands; i++) {
+                pthread_join(islands[i].thread, NULL);
+                if (islands[i].best_chrom->unfitness
+                    < islands[best_i].best_chrom->unfitness) {
+                        best_i = i;
+                }
+                if (islands[i].num_gens_passed > num_gens_passed) {
+                        num_gens_passed = islands[i].num_gens_passed;
+                }
+        }
+        result_t *res = result_malloc(islands[best_i].best_chrom,
+                                      ps->item_vals, num_gens_passed);
+        if (stats != NULL) {
+                *stats = (ga_stats_t){0};
+                for (size_t i=0; i<num_islands; i++) {
+                        ga_stats_add(stats, &islands[i].stats);
+                }
+        }
+        for (size_t i=0; i<num_islands; i++) {
+                pop_arena_free(islands[i].arenas[0]);
+                pop_arena_free(islands[i].arenas[1]);
+                free(islands[i].pool);
+                free(islands[i].picked);
+                chrom_free(islands[i].best_chrom);
+                ring_free(rings[i]);
+        }
+        free(rings);
+        free(islands);
+        return res;
+}
+
+static struct migration_ring *ring_malloc(size_t capacity, size_t num_bits) {
+        struct migration_ring *ring = ga_aligned_alloc(CACHE_LINE,
+                                                       sizeof(*ring));
+        ring->capacity = capacity;
+        ring->stride = BITS2WORDS(num_bits);
+        ring->words = ga_malloc(sizeof(*ring->words) * ring->stride
+                                * capacity);
+        ring->diff = ga_malloc(sizeof(*ring->diff) * capacity);
+        atomic_init(&ring->closed, false);
+        atomic_init(&ring->abandoned, false);
+        atomic_init(&ring->head, 0);
+        atomic_init(&ring->tail, 0);
+        return ring;
+}
+static void ring_free(struct migration_ring *ring) {
+        free(ring->words);
+        free(ring->diff);
+        free(ring);
+}
+static void *run_island(void *island_ptr) {
+        struct island *island = (struct island *)island_ptr;
+        struct island_run *run = island->run;
+        size_t cur = 0;
+        size_t island_size = island->arenas[cur]->num_chroms;
+        ga_gen_record_t rec = {0};
+        double *timers = (run->ctx->trace != NULL) ? rec.phase_seconds
+                                                   : NULL;
+        struct timespec lap;
+        size_t num_allocs = ga_num_allocs;
+        initial_pop(island->arenas[cur], 0, island_size, run->ctx,
+                    &island->rng);
+        track_best(island, island->arenas[cur]);
+        if (timers != NULL) {
+                record_gen(island, &rec, 0, island->arenas[cur], num_allocs);
+        }
+        size_t num_gens_passed = 1;
+        size_t stall_gens = 0;
+        while (!ga_converged(run->ctx, num_gens_passed,
+                             island->best_chrom->unfitness, stall_gens)
+               && !ga_past_deadline(run->ctx)) {
+                pop_arena_t *pop = island->arenas[cur];
+                pop_arena_t *next = island->arenas[!cur];
+                num_allocs = ga_num_allocs;
+                ga_lap_start(timers, &lap);
+                tourn_select(pop, island->pool, 0, island_size, run->ctx,
+                             &island->rng);
+                ga_lap(timers, GA_PHASE_SELECT, &lap);
+                new_gen(pop, island->pool, next, 0, island_size, run->ctx,
+                        &island->rng, &island->stats, timers);
+                ga_lap_start(timers, &lap);
+                cur = !cur;
+                long long prev_unfitness = island->best_chrom->unfitness;
+                track_best(island, next);
+                ga_lap(timers, GA_PHASE_FITTEST, &lap);
+                stall_gens = (island->best_chrom->unfitness < prev_unfitness)
+                             ? 0
+                             : stall_gens + 1;
+                num_gens_passed++;
+                if (num_gens_passed % run->migration_interval == 0
+                    && run->num_migrants > 0) {
+                        migrate(island, next);
+                        ga_lap(timers, GA_PHASE_MIGRATION, &lap);
+                }
+                if (timers != NULL) {
+                        record_gen(island, &rec, num_gens_passed - 1, next,
+                                   num_allocs);
+                }
+                if (num_gens_passed % run->migration_interval == 0
+                    && others_reached(island, num_gens_passed)) {
+                        break;
+                }
+        }
+        if (island->best_chrom->unfitness <= run->ctx->target_diff) {
+                island->reached_gen = num_gens_passed;
+        }
+        atomic_store_explicit(&island->progress, SIZE_MAX,
+                              memory_order_release);
+        atomic_store_explicit(&island->out->closed, true,
+                              memory_order_release);
+        atomic_store_explicit(&island->in->abandoned, true,
+                              memory_order_release);
+        island->num_gens_passed = num_gens_passed;
+        return NULL;
+}
+static void record_gen(const struct island *island, ga_gen_record_t *rec,
+                       size_t gen, const pop_arena_t *pop,
+                       size_t num_allocs) {
+        rec->gen = gen;
+        rec->island = island->index;
+        ga_record_pop(rec, pop, island->run->ctx);
+        rec->num_allocs = ga_num_allocs - num_allocs;
+        ga_trace_add(island->run->ctx->trace, rec);
+        for (size_t p=0; p<GA_NUM_PHASES; p++) {
+                rec->phase_seconds[p] = 0;
+        }
+}
+static void track_best(struct island *island, const pop_arena_t *pop) {
+        size_t fittest_i = find_fittest(pop, 0, pop->num_chroms);
+        if (pop->unfitness[fittest_i] < island->best_chrom->unfitness) {
+                island->best_chrom->unfitness = pop->unfitness[fittest_i];
+                memcpy(island->best_chrom->words, ARENA_CHROM(pop, fittest_i),
+                       sizeof(uint64_t) * pop->stride);
+        }
+}
+static void pick_extremes(const pop_arena_t *pop, size_t *picked,
+                          size_t num_picked, bool worst) {
+        /* insertion into a short sorted list; num_picked is small */
+        size_t count = 0;
+        for (size_t i=0; i<pop->num_chroms; i++) {
+                long long unfitness = worst ? -pop->unfitness[i]
+                                            : pop->unfitness[i];
+                size_t j = count;
+                while (j > 0) {
+                        long long other = worst
+                                          ? -pop->unfitness[picked[j - 1]]
+                                          : pop->unfitness[picked[j - 1]];
+                        if (other <= unfitness) {
+                                break;
+                        }
+                        if (j < num_picked) {
+                                picked[j] = picked[j - 1];
+                        }
+                        j--;
+                }
+                if (j < num_picked) {
+                        picked[j] = i;
+                        if (count < num_picked) {
+                                count++;
+                        }
+                }
+        }
+}
+static void migrate(struct island *island, pop_arena_t *pop) {
+        struct island_run *run = island->run;
+        struct migration_ring *out = island->out;
+        struct migration_ring *in = island->in;
+        size_t num_migrants = run->num_migrants;
+        size_t stride = pop->stride;
+
+        pick_extremes(pop, island->picked, num_migrants, false);
+        size_t tail = atomic_load_explicit(&out->tail, memory_order_relaxed);
+        while (tail + num_migrants
+               > atomic_load_explicit(&out->head, memory_order_acquire)
+                 + out->capacity) {
+                if (atomic_load_explicit(&out->abandoned,
+                                         memory_order_acquire)) {
+                        return;
+                }
+                sched_yield();
+        }
+        for (size_t m=0; m<num_migrants; m++) {
+                size_t slot = (tail + m) % out->capacity;
+                memcpy(out->words + slot * stride,
+                       ARENA_CHROM(pop, island->picked[m]),
+                       sizeof(uint64_t) * stride);
+                out->diff[slot] = pop->diff[island->picked[m]];
+        }
+        atomic_store_explicit(&out->tail, tail + num_migrants,
+                              memory_order_release);
+
+        /* waiting for the full batch keeps runs deterministic; a neighbour
+         * that has exited sends nothing more */
+        size_t head = atomic_load_explicit(&in->head, memory_order_relaxed);
+        size_t available;
+        while ((available = atomic_load_explicit(&in->tail,
+                                                 memory_order_acquire)
+                            - head) < num_migrants) {
+                if (atomic_load_explicit(&in->closed, memory_order_acquire)) {
+                        available = atomic_load_explicit(
+                                        &in->tail, memory_order_acquire)
+                                    - head;
+                        break;
+                }
+                sched_yield();
+        }
+        if (available > num_migrants) {
+                available = num_migrants;
+        }
+        pick_extremes(pop, island->picked, available, true);
+        for (size_t m=0; m<available; m++) {
+                size_t slot = (head + m) % in->capacity;
+                memcpy(ARENA_CHROM(pop, island->picked[m]),
+                       in->words + slot * stride,
+                       sizeof(uint64_t) * stride);
+                pop->diff[island->picked[m]] = in->diff[slot];
+                pop->unfitness[island->picked[m]] = (in->diff[slot] < 0)
+                                                    ? -in->diff[slot]
+                                                    : in->diff[slot];
+        }
+        atomic_store_explicit(&in->head, head + available,
+                              memory_order_release);
+}
+static bool others_reached(struct island *island, size_t num_gens_passed) {
+        struct island_run *run = island->run;
+        /* an island that has reached the target exits without publishing
+         * the boundary, so that the others find it exited */
+        if (island->best_chrom->unfitness <= run->ctx->target_diff) {
+                return true;
+        }
+        atomic_store_explicit(&island->progress, num_gens_passed,
+                              memory_order_release);
+        for (size_t i=0; i<run->num_islands; i++) {
+                struct island *other = run->islands + i;
+                if (other == island) {
+                        continue;
+                }
+                size_t progress;
+                while ((progress = atomic_load_explicit(
+                                        &other->progress,
+                                        memory_order_acquire))
+                       < num_gens_passed) {
+                        sched_yield();
+                }
+                /* an island still running has not reached the target, or it
+                 * would have exited */
+                if (progress == SIZE_MAX
+                    && other->reached_gen <= num_gens_passed) {
+                        return true;
+                }
+        }
+        return false;
+}
@@ -0,0 +1,152 @@
+#include "differencing.h"
+#include "prob-file.h"
+#include "ga-config.h"
+#include "out-buf.h"
+#include "fitness.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+void print_set(const char *name, const result_t *res, unsigned set);
+/** Prints the usage of the driver, run as prog, on stderr */
+void print_usage(const char *prog);
+
+/* Usage: karmarkar-karp.out [-c [-t threads] [-l seconds] [-n nodes]]
+ *                           [-F problem_file] [-w result_file] < input
+ * Partitions the items with the Largest Differencing Method; input format is
+ * the same as genetic-algorithm.out's
+ * -c           search for an optimal partition with the Complete
+ *              Karmarkar-Karp branch and bound, reporting whether optimality
+ *              was proven within the budget. Instances whose sum of absolute
+ *              item values exceeds the range of a long long are not searched
+ *              and get the plain method's partition, with a warning
+ * -t           number of threads splitting the search; defaults to 1
+ * -l           wall-clock budget of the search in seconds; defaults to none
+ * -n           budget of search nodes; defaults to none
+ * -F           maps a binary problem file instead of reading stdin
+ * -w           also writes the partition to a binary result file */
+int main(int argc, char **argv) {
+        bool complete = false;
+        const char *prob_path = NULL;
+        const char *result_path = NULL;
+        ckk_params_t params;
+        ckk_params_init(&params);
+        int opt;
+        unsigned long long val;
+        while ((opt = getopt(argc, argv, "ct:l:n:F:w:")) != -1) {
+                switch (opt) {
+                case 'c':
+                        complete = true;
+                        break;
+                case 't':
+                case 'n':
+                        if (!config_parse_ull(optarg, &val)
+                            || (opt == 't' && val > SIZE_MAX)) {
+                                fprintf(stderr, "bad -%c: %s\n", opt,
+                                        optarg);
+                                print_usage(argv[0]);
+                                return 1;
+                        }
+                        if (opt == 't') {
+                                params.num_threads = val;
+                        } else {
+                                params.node_limit = val;
+                        }
+                        break;
+                case 'l':
+                        if (!config_parse_double(optarg,
+                                                 &params.time_limit)) {
+                                fprintf(stderr, "bad -l: %s\n", optarg);
+                                print_usage(argv[0]);
+                                return 1;
+                        }
+                        break;
+                case 'F':
+                        prob_path = optarg;
+                        break;
+                case 'w':
+                        result_path = optarg;
+                        break;
+                default:
+                        print_usage(argv[0]);
+                        return 1;
+                }
+        }
+        prob_io_status_t status;
+        prob_set_t *read_ps = NULL;
+        prob_file_t *pf = NULL;
+        const prob_set_t *ps;
+        if (prob_path != NULL) {
+                pf = prob_file_map(prob_path, false, &status);
+                ps = (pf != NULL) ? pf->ps : NULL;
+        } else {
+                read_ps = prob_set_read(stdin, &status);
+                ps = read_ps;
+        }
+        if (ps == NULL) {
+                fprintf(stderr, "bad input: %s\n", prob_io_strerror(status));
+                return 1;
+        }
+        if (complete
+            && fitness_width(ps->item_vals, ps->num_items) == FITNESS_WIDE) {
+                fprintf(stderr, "warning: -c search skipped: the item sums "
+                        "exceed the range of a long long\n");
+        }
+        ckk_stats_t stats;
+        result_t *res = complete ? num_part_2way_ckk(ps, &params, &stats)
+                                 : num_part_2way_kk(ps);
+        print_set("set0", res, 0);
+        print_set("set1", res, 1);
+        printf("sum diff = ");
+        fprint_int128(stdout, result_diff(res));
+        putchar('\n');
+        if (complete) {
+                printf("proven optimal: %s\n"
+                       "nodes searched: %llu\n"
+                       "seconds: %f\n",
+                       stats.proven ? "yes" : "no", stats.num_nodes,
+                       stats.seconds);
+        }
+        int ret = 0;
+        if (result_path != NULL) {
+                FILE *out = fopen(result_path, "wb");
+                status = (out != NULL) ? result_file_write(out, res, ps)
+                                       : PROB_IO_WRITE_ERROR;
+                if (out != NULL && fclose(out) != 0) {
+                        status = PROB_IO_WRITE_ERROR;
+                }
+                if (status != PROB_IO_OK) {
+                        fprintf(stderr, "%s: %s\n", result_path,
+                                prob_io_strerror(status));
+                        ret = 1;
+                }
+        }
+        result_free(res);
+        if (pf != NULL) {
+                prob_file_unmap(pf);
+        } else {
+                prob_set_free(read_ps);
+        }
+        return ret;
+}
+
+void print_set(const char *name, const result_t *res, unsigned set) {
+        printf("%s:\nset sum: ", name);
+        fprint_int128(stdout, (set == 0) ? res->set0_sum
+                                         : res->set1_sum);
+        printf("\nset items:\n");
+        result_iter_t it;
+        result_iter_init(&it, res, set);
+        long long val;
+        while (result_iter_next(&it, &val)) {
+                printf("%lld ", val);
+        }
+        putchar('\n');
+}
+void print_usage(const char *prog) {
+        fprintf(stderr, "usage: %s [-c [-t threads] [-l seconds] [-n nodes]] "
+                "[-F problem_file] [-w result_file]\n"
+                "-c searches only instances whose sum of absolute item values "
+                "fits in a long long\n", prog);
+}
@@ -0,0 +1,230 @@
+/** Implements the memetic local search stage declared in ga-engine.h
+ *
+ * With D the signed difference of a chromosome, h = |D| and the heavy side
+ * the set with the larger sum, moving an item of value v off the heavy side
+ * leaves |h - 2v|, moving one off the light side |h + 2v| and swapping a
+ * heavy item a with a light item b leaves |h - 2(a - b)|. Each candidate is
+ * therefore the item of one side whose doubled value is closest to a target,
+ * found by binary search over the items sorted by value
+ * @file local-search.c */
+#include "ga-engine.h"
+#include <stdlib.h>
+#include <time.h>
+#include <assert.h>
+
+/** Number of items scanned on each side of the binary search position for
+ * one on the wanted side of the partition; items of the other side are
+ * skipped over, and a scan that finds none gives up */
+#define LS_SCAN_LIMIT                   16
+
+/** Returns whether item i is in set1 */
+static unsigned item_bit(const uint64_t *words, size_t i);
+/** Flips the set of item i */
+static void flip_item(uint64_t *words, size_t i);
+/** Returns |2 * item_vals[i] - target2| */
+static unsigned __int128 closeness(const ga_ctx_t *ctx, size_t i,
+                                   __int128 target2);
+/** Returns the item with the given set bit whose doubled value is closest to
+ * target2, or SIZE_MAX if none was found within LS_SCAN_LIMIT positions of
+ * where target2 falls in ctx->sorted */
+static size_t find_closest(const ga_ctx_t *ctx, const uint64_t *words,
+                           unsigned bit, __int128 target2);
+/** Runs steepest descent over single moves and swaps on chromosome i of pop
+ * until no move improves it or the deadline passes, updating its difference
+ * and unfitness; returns false if the deadline cut it short */
+static bool improve_chrom(pop_arena_t *pop, size_t i, const ga_ctx_t *ctx,
+                          const struct timespec *deadline,
+                          ga_stats_t *stats);
+
+void local_search(pop_arena_t *pop, size_t lo, size_t hi,
+                  const ga_ctx_t *ctx, ga_stats_t *stats) {
+        if (ctx->ls_top_k == 0 || lo == hi) {
+                return;
+        }
+        double start = mono_now();
+        struct timespec deadline = mono_after(ctx->ls_budget);
+        /* each slice improves its share of the ls_top_k fittest, rounded
+         * up so that every non-empty slice takes part */
+        size_t slice_size = hi - lo;
+        size_t num_picked = (ctx->ls_top_k * slice_size + pop->num_chroms - 1)
+                            / pop->num_chroms;
+        if (num_picked > slice_size) {
+                num_picked = slice_size;
+        }
+        size_t *picked = ga_malloc(sizeof(*picked) * num_picked);
+        /* insertion into a sorted list, ties by index so that the choice
+         * does not depend on the slicing */
+        size_t count = 0;
+        for (size_t i=lo; i<hi; i++) {
+                size_t j = count;
+                while (j > 0 && pop->unfitness[picked[j - 1]]
+                                > pop->unfitness[i]) {
+                        if (j < num_picked) {
+                                picked[j] = picked[j - 1];
+                        }
+                        j--;
+                }
+                if (j < num_picked) {
+                        picked[j] = i;
+                        if (count < num_picked) {
+                                count++;
+                        }
+                }
+        }
+        const struct timespec *limit = (ctx->ls_budget > 0) ? &deadline
+                                                            : NULL;
+        for (size_t k=0; k<count; k++) {
+                if (!improve_chrom(pop, picked[k], ctx, limit, stats)) {
+                        if (stats != NULL) {
+                                stats->ls_budget_hits++;
+                        }
+                        break;
+                }
+        }
+        free(picked);
+        if (stats != NULL) {
+                stats->ls_seconds += mono_now() - start;
+        }
+}
+
+static unsigned item_bit(const uint64_t *words, size_t i) {
+        return (words[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+}
+static void flip_item(uint64_t *words, size_t i) {
+        words[i / WORD_BITS] ^= (uint64_t)1 << (i % WORD_BITS);
+}
+static unsigned __int128 closeness(const ga_ctx_t *ctx, size_t i,
+                                   __int128 target2) {
+        __int128 dist = 2 * (__int128)ctx->item_vals[i] - target2;
+        return (dist < 0) ? -(unsigned __int128)dist
+                          : (unsigned __int128)dist;
+}
+static size_t find_closest(const ga_ctx_t *ctx, const uint64_t *words,
+                           unsigned bit, __int128 target2) {
+        const size_t *sorted = ctx->sorted;
+        /* first position whose doubled value is at most target2; values
+         * decrease along sorted */
+        size_t lo = 0;
+        size_t hi = ctx->num_items;
+        while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (2 * (__int128)ctx->item_vals[sorted[mid]] > target2) {
+                        lo = mid + 1;
+                } else {
+                        hi = mid;
+                }
+        }
+        size_t best = SIZE_MAX;
+        for (size_t p=lo, n=0; p<ctx->num_items && n<LS_SCAN_LIMIT;
+             p++, n++) {
+                if (item_bit(words, sorted[p]) == bit) {
+                        best = sorted[p];
+                        break;
+                }
+        }
+        for (size_t p=lo, n=0; p>0 && n<LS_SCAN_LIMIT; p--, n++) {
+                if (item_bit(words, sorted[p - 1]) == bit) {
+                        if (best == SIZE_MAX
+                            || closeness(ctx, sorted[p - 1], target2)
+                               < closeness(ctx, best, target2)) {
+                                best = sorted[p - 1];
+                        }
+                        break;
+                }
+        }
+        return best;
+}
+static bool improve_chrom(pop_arena_t *pop, size_t i, const ga_ctx_t *ctx,
+                          const struct timespec *deadline,
+                          ga_stats_t *stats) {
+        uint64_t *words = ARENA_CHROM(pop, i);
+        long long diff = pop->diff[i];
+        long long start_unfitness = pop->unfitness[i];
+        size_t num_moves = 0;
+        size_t num_swaps = 0;
+        bool finished = true;
+        while (diff != 0) {
+                if (deadline != NULL && mono_passed(deadline)) {
+                        finished = false;
+                        break;
+                }
+                /* set0 is heavy when the difference is positive */
+                unsigned heavy = diff < 0;
+                __int128 h = (diff < 0) ? -(__int128)diff : diff;
+                unsigned __int128 best = (unsigned __int128)h;
+                size_t best_a = SIZE_MAX;
+                size_t best_b = SIZE_MAX;
+                size_t a = find_closest(ctx, words, heavy, h);
+                if (a != SIZE_MAX && closeness(ctx, a, h) < best) {
+                        best = closeness(ctx, a, h);
+                        best_a = a;
+                }
+                size_t b = find_closest(ctx, words, !heavy, -h);
+                if (b != SIZE_MAX && closeness(ctx, b, -h) < best) {
+                        best = closeness(ctx, b, -h);
+                        best_a = SIZE_MAX;
+                        best_b = b;
+                }
+                for (size_t s=0; s<ctx->num_items; s++) {
+                        size_t x = ctx->sorted[s];
+                        if (item_bit(words, x) != heavy) {
+                                continue;
+                        }
+                        __int128 target2 = 2 * (__int128)ctx->item_vals[x]
+                                           - h;
+                        size_t y = find_closest(ctx, words, !heavy, target2);
+                        if (y != SIZE_MAX
+                            && closeness(ctx, y, target2) < best) {
+                                best = closeness(ctx, y, target2);
+                                best_a = x;
+                                best_b = y;
+                                if (best == 0) {
+                                        break;
+                                }
+                        }
+                }
+                if (best == (unsigned __int128)h) {
+                        break;
+                }
+                if (best_a != SIZE_MAX) {
+                        flip_item(words, best_a);
+                }
+                if (best_b != SIZE_MAX) {
+                        flip_item(words, best_b);
+                }
+                if (best_a != SIZE_MAX && best_b != SIZE_MAX) {
+                        num_swaps++;
+                } else {
+                        num_moves++;
+                }
+                /* the heavy side stays heavy, or becomes the light one,
+                 * by the remaining amount */
+                __int128 new_h = h - 2 * ((best_a != SIZE_MAX)
+                                          ? (__int128)ctx->item_vals[best_a]
+                                          : 0)
+                                 + 2 * ((best_b != SIZE_MAX)
+                                        ? (__int128)ctx->item_vals[best_b]
+                                        : 0);
+                diff = (long long)((diff < 0) ? -new_h : new_h);
+        }
+        if (words_normalize(words, pop->num_bits)) {
+                diff = -diff;
+        }
+#ifdef FITNESS_CHECK
+        assert(diff == fitness_diff(words, ctx->item_vals, ctx->num_items,
+                                    (long long)ctx->total));
+#endif
+        pop->diff[i] = diff;
+        pop->unfitness[i] = (diff < 0) ? -diff : diff;
+        if (stats != NULL) {
+                stats->ls_chroms++;
+                stats->ls_moves += num_moves;
+                stats->ls_swaps += num_swaps;
+                if (pop->unfitness[i] < start_unfitness) {
+                        stats->ls_improved++;
+                        stats->ls_gain += (double)(start_unfitness
+                                                   - pop->unfitness[i]);
+                }
+        }
+        return finished;
+}
@@ -0,0 +1,411 @@
+/** Microbenchmarks of the chromosome and population operations and of whole
+ * generations, reporting the median and 99th percentile time of each over
+ * repeated samples, with a regression mode that compares them against a
+ * saved baseline
+ * @file micro-bench.c */
+#include "ga-engine.h"
+#include "ga-config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+
+/** Sizes timed by default */
+#define MAX_ITEMS               100000
+/** Default number of samples timed per benchmark and size */
+#define NUM_SAMPLES             51
+/** Default number of untimed samples run first */
+#define NUM_WARMUP              5
+/** Shortest a sample may take; operations are repeated until it does, so
+ * that the clock's resolution does not dominate the fast ones */
+#define MIN_SAMPLE_NS           100000.0
+/** Population of the population-wide benchmarks: N chromosomes up to this
+ * many, so that the largest sizes stay within memory */
+#define MAX_POP                 256
+/** Number of chromosomes cycled through by the per-chromosome benchmarks */
+#define NUM_CHROMS              64
+/** Default ratio of the median to the baseline's median above which a
+ * benchmark counts as regressed */
+#define DEFAULT_THRESHOLD       1.2
+/** Longest benchmark name in a baseline file */
+#define MAX_NAME                32
+
+/** Everything the benchmarks of one size work on */
+struct fixture {
+        size_t num_items;
+        rng_t rng;
+        prob_set_t *ps;
+        ga_ctx_t ctx;
+        chrom_t *chroms[NUM_CHROMS];
+        /** Population of ctx.pop_size chromosomes and the one bred from it;
+         * swapped after every generation */
+        pop_arena_t *pop;
+        pop_arena_t *next;
+        size_t *pool;
+        /** Cycles through chroms */
+        size_t next_chrom;
+};
+/** A benchmark runs reps of its operation on the fixture */
+struct bench {
+        const char *name;
+        /** What one operation is, e.g. "chrom" for one chromosome */
+        const char *unit;
+        void (*run)(struct fixture *fixture, size_t reps);
+};
+/** Median and 99th percentile of a benchmark at one size */
+struct measurement {
+        char name[MAX_NAME];
+        size_t num_items;
+        double median_ns;
+        double p99_ns;
+};
+
+/** Sets up the fixture for num_items items with population-wide benchmarks
+ * over min(num_items, MAX_POP) chromosomes */
+static void fixture_init(struct fixture *fixture, size_t num_items);
+/** Frees what fixture_init allocated */
+static void fixture_free(struct fixture *fixture);
+/** Returns the next chromosome of the fixture's cycle */
+static chrom_t *next_chrom(struct fixture *fixture);
+static void run_chrom_rand(struct fixture *fixture, size_t reps);
+static void run_chrom_ucx(struct fixture *fixture, size_t reps);
+static void run_chrom_mutate(struct fixture *fixture, size_t reps);
+static void run_chrom_invert(struct fixture *fixture, size_t reps);
+static void run_fitness(struct fixture *fixture, size_t reps);
+static void run_tourn_select(struct fixture *fixture, size_t reps);
+static void run_generation(struct fixture *fixture, size_t reps);
+/** Times bench on the fixture: calibrates the repetitions per sample, runs
+ * num_warmup samples untimed and returns the statistics of num_samples
+ * timed ones, in nanoseconds per operation */
+static struct measurement measure(const struct bench *bench,
+                                  struct fixture *fixture,
+                                  size_t num_warmup, size_t num_samples);
+/** qsort comparator of doubles */
+static int cmp_double(const void *a, const void *b);
+/** Reads the measurements of a baseline file, setting *count; returns NULL
+ * if it cannot be read */
+static struct measurement *read_baseline(const char *path, size_t *count);
+/** Returns the measurement of the baseline with the same name and size as m,
+ * or NULL */
+static const struct measurement *find_baseline(const struct measurement *m,
+                                               const struct measurement *base,
+                                               size_t num_base);
+/** Prints the usage of the suite, run as prog, on stderr */
+static void print_usage(const char *prog);
+
+static const struct bench benches[] = {
+        {"chrom_rand", "chrom", run_chrom_rand},
+        {"chrom_ucx", "chrom", run_chrom_ucx},
+        {"chrom_mutate", "chrom", run_chrom_mutate},
+        {"chrom_invert", "chrom", run_chrom_invert},
+        {"fitness", "pop", run_fitness},
+        {"tourn_select", "pop", run_tourn_select},
+        {"generation", "gen", run_generation}
+};
+
+/* Usage: micro-bench.out [-n max_items] [-s samples] [-w warmup]
+ *                        [-b benchmark] [-o baseline_out]
+ *                        [-c baseline_in [-t threshold]]
+ * Times every benchmark at N = 10, 100, ... up to max_items (default
+ * 100000) and prints the median and 99th percentile time per operation: a
+ * chromosome for the chrom_ benchmarks, a population of min(N, 256)
+ * chromosomes for fitness and tourn_select, and a whole generation of
+ * selection, breeding, evaluation and finding the fittest of that
+ * population for generation
+ * -s           timed samples per benchmark and size; defaults to 51
+ * -w           untimed warmup samples; defaults to 5
+ * -b           only runs the named benchmark
+ * -o           saves the measurements as a baseline file
+ * -c           compares the medians against a baseline file, exiting with
+ *              status 1 if any is more than threshold (default 1.2) times
+ *              its baseline */
+int main(int argc, char **argv) {
+        size_t max_items = MAX_ITEMS;
+        size_t num_samples = NUM_SAMPLES;
+        size_t num_warmup = NUM_WARMUP;
+        const char *only = NULL;
+        const char *out_path = NULL;
+        const char *base_path = NULL;
+        double threshold = DEFAULT_THRESHOLD;
+        int opt;
+        unsigned long long val;
+        while ((opt = getopt(argc, argv, "n:s:w:b:o:c:t:")) != -1) {
+                switch (opt) {
+                case 'n':
+                case 's':
+                case 'w':
+                        if (!config_parse_ull(optarg, &val)
+                            || val > SIZE_MAX) {
+                                fprintf(stderr, "bad -%c: %s\n", opt,
+                                        optarg);
+                                print_usage(argv[0]);
+                                return 1;
+                        }
+                        if (opt == 'n') {
+                                max_items = val;
+                        } else if (opt == 's') {
+                                num_samples = val;
+                        } else {
+                                num_warmup = val;
+                        }
+                        break;
+                case 'b':
+                        only = optarg;
+                        break;
+                case 'o':
+                        out_path = optarg;
+                        break;
+                case 'c':
+                        base_path = optarg;
+                        break;
+                case 't':
+                        if (!config_parse_double(optarg, &threshold)) {
+                                fprintf(stderr, "bad -t: %s\n", optarg);
+                                print_usage(argv[0]);
+                                return 1;
+                        }
+                        break;
+                default:
+                        print_usage(argv[0]);
+                        return 1;
+                }
+        }
+        if (num_samples == 0) {
+                num_samples = 1;
+        }
+        struct measurement *base = NULL;
+        size_t num_base = 0;
+        if (base_path != NULL
+            && (base = read_baseline(base_path, &num_base)) == NULL) {
+                fprintf(stderr, "cannot read baseline %s\n", base_path);
+                return 1;
+        }
+        FILE *out = NULL;
+        if (out_path != NULL && (out = fopen(out_path, "w")) == NULL) {
+                perror(out_path);
+                free(base);
+                return 1;
+        }
+        printf("%-14s %7s %6s %14s %14s", "benchmark", "N", "per",
+               "median ns", "p99 ns");
+        printf(base != NULL ? " %14s %8s\n" : "\n", "baseline ns", "ratio");
+        size_t num_regressed = 0;
+        for (size_t n=10; n<=max_items; n*=10) {
+                struct fixture fixture;
+                fixture_init(&fixture, n);
+                for (size_t b=0; b<sizeof(benches)/sizeof(*benches); b++) {
+                        const struct bench *bench = benches + b;
+                        if (only != NULL && strcmp(only, bench->name) != 0) {
+                                continue;
+                        }
+                        struct measurement m = measure(bench, &fixture,
+                                                       num_warmup,
+                                                       num_samples);
+                        printf("%-14s %7zu %6s %14.1f %14.1f", m.name,
+                               m.num_items, bench->unit, m.median_ns,
+                               m.p99_ns);
+                        if (out != NULL) {
+                                fprintf(out, "%s %zu %f %f\n", m.name,
+                                        m.num_items, m.median_ns, m.p99_ns);
+                        }
+                        const struct measurement *prev
+                                = (base != NULL)
+                                  ? find_baseline(&m, base, num_base)
+                                  : NULL;
+                        if (prev != NULL) {
+                                double ratio = m.median_ns / prev->median_ns;
+                                bool regressed = ratio > threshold;
+                                num_regressed += regressed;
+                                printf(" %14.1f %8.2f%s", prev->median_ns,
+                                       ratio,
+                                       regressed ? "  REGRESSED" : "");
+                        } else if (base != NULL) {
+                                printf(" %14s %8s", "-", "-");
+                        }
+                        putchar('\n');
+                        fflush(stdout);
+                }
+                fixture_free(&fixture);
+        }
+        free(base);
+        if (out != NULL && fclose(out) != 0) {
+                perror(out_path);
+                return 1;
+        }
+        if (num_regressed > 0) {
+                printf("%zu benchmark(s) more than %.2fx slower than the "
+                       "baseline\n", num_regressed, threshold);
+                return 1;
+        }
+        return 0;
+}
+
+static void fixture_init(struct fixture *fixture, size_t num_items) {
+        fixture->num_items = num_items;
+        rng_seed(&fixture->rng, 1);
+        fixture->ps = prob_set_malloc(num_items);
+        for (size_t i=0; i<num_items; i++) {
+                /* bounded like the "rand" datasets */
+                fixture->ps->item_vals[i] = rng_below(&fixture->rng,
+                                                      LLONG_MAX / num_items);
+        }
+        size_t pop_size = (num_items < MAX_POP) ? num_items : MAX_POP;
+        ga_params_t params;
+        ga_params_init(&params);
+        params.pop_size_factor = (double)pop_size / num_items;
+        ga_ctx_init(&fixture->ctx, fixture->ps, &params);
+        for (size_t i=0; i<NUM_CHROMS; i++) {
+                fixture->chroms[i] = chrom_rand(num_items, &fixture->rng);
+        }
+        fixture->next_chrom = 0;
+        fixture->pop = pop_arena_malloc(fixture->ctx.pop_size, num_items);
+        fixture->next = pop_arena_malloc(fixture->ctx.pop_size, num_items);
+        fixture->pool = malloc(sizeof(*fixture->pool)
+                               * fixture->ctx.pop_size);
+        initial_pop(fixture->pop, 0, fixture->ctx.pop_size, &fixture->ctx,
+                    &fixture->rng);
+}
+static void fixture_free(struct fixture *fixture) {
+        for (size_t i=0; i<NUM_CHROMS; i++) {
+                chrom_free(fixture->chroms[i]);
+        }
+        pop_arena_free(fixture->pop);
+        pop_arena_free(fixture->next);
+        free(fixture->pool);
+        ga_ctx_free(&fixture->ctx);
+        prob_set_free(fixture->ps);
+}
+static chrom_t *next_chrom(struct fixture *fixture) {
+        chrom_t *chrom = fixture->chroms[fixture->next_chrom];
+        fixture->next_chrom = (fixture->next_chrom + 1) % NUM_CHROMS;
+        return chrom;
+}
+static void run_chrom_rand(struct fixture *fixture, size_t reps) {
+        for (size_t r=0; r<reps; r++) {
+                chrom_free(chrom_rand(fixture->num_items, &fixture->rng));
+        }
+}
+static void run_chrom_ucx(struct fixture *fixture, size_t reps) {
+        for (size_t r=0; r<reps; r++) {
+                chrom_t *parent1 = next_chrom(fixture);
+                chrom_t *parent2 = next_chrom(fixture);
+                chrom_free(chrom_ucx(parent1, parent2, &fixture->rng));
+        }
+}
+static void run_chrom_mutate(struct fixture *fixture, size_t reps) {
+        for (size_t r=0; r<reps; r++) {
+                chrom_mutate(next_chrom(fixture), &fixture->rng);
+        }
+}
+static void run_chrom_invert(struct fixture *fixture, size_t reps) {
+        for (size_t r=0; r<reps; r++) {
+                chrom_invert(next_chrom(fixture));
+        }
+}
+static void run_fitness(struct fixture *fixture, size_t reps) {
+        for (size_t r=0; r<reps; r++) {
+                pop_calc_fitness(fixture->pop, 0, fixture->ctx.pop_size,
+                                 &fixture->ctx);
+        }
+}
+static void run_tourn_select(struct fixture *fixture, size_t reps) {
+        for (size_t r=0; r<reps; r++) {
+                tourn_select(fixture->pop, fixture->pool, 0,
+                             fixture->ctx.pop_size, &fixture->ctx,
+                             &fixture->rng);
+        }
+}
+static void run_generation(struct fixture *fixture, size_t reps) {
+        /* the steps of a generation in the single-threaded engine */
+        size_t pop_size = fixture->ctx.pop_size;
+        for (size_t r=0; r<reps; r++) {
+                tourn_select(fixture->pop, fixture->pool, 0, pop_size,
+                             &fixture->ctx, &fixture->rng);
+                new_gen(fixture->pop, fixture->pool, fixture->next, 0,
+                        pop_size, &fixture->ctx, &fixture->rng, NULL, NULL);
+                find_fittest(fixture->next, 0, pop_size);
+                pop_arena_t *tmp = fixture->pop;
+                fixture->pop = fixture->next;
+                fixture->next = tmp;
+        }
+}
+static struct measurement measure(const struct bench *bench,
+                                  struct fixture *fixture,
+                                  size_t num_warmup, size_t num_samples) {
+        /* doubles the repetitions until a sample is long enough */
+        size_t reps = 1;
+        while (true) {
+                double t0 = mono_now_ns();
+                bench->run(fixture, reps);
+                if (mono_now_ns() - t0 >= MIN_SAMPLE_NS) {
+                        break;
+                }
+                reps *= 2;
+        }
+        for (size_t w=0; w<num_warmup; w++) {
+                bench->run(fixture, reps);
+        }
+        double *samples = malloc(sizeof(*samples) * num_samples);
+        for (size_t s=0; s<num_samples; s++) {
+                double t0 = mono_now_ns();
+                bench->run(fixture, reps);
+                samples[s] = (mono_now_ns() - t0) / reps;
+        }
+        qsort(samples, num_samples, sizeof(*samples), cmp_double);
+        struct measurement m;
+        snprintf(m.name, sizeof(m.name), "%s", bench->name);
+        m.num_items = fixture->num_items;
+        m.median_ns = samples[num_samples / 2];
+        /* nearest rank */
+        size_t rank = (99 * num_samples + 99) / 100;
+        m.p99_ns = samples[rank - 1];
+        free(samples);
+        return m;
+}
+static int cmp_double(const void *a, const void *b) {
+        double x = *(const double *)a;
+        double y = *(const double *)b;
+        return (x > y) - (x < y);
+}
+static struct measurement *read_baseline(const char *path, size_t *count) {
+        FILE *in = fopen(path, "r");
+        if (in == NULL) {
+                return NULL;
+        }
+        size_t capacity = 64;
+        struct measurement *base = malloc(sizeof(*base) * capacity);
+        *count = 0;
+        struct measurement m;
+        while (fscanf(in, "%31s %zu %lf %lf", m.name, &m.num_items,
+                      &m.median_ns, &m.p99_ns) == 4) {
+                if (*count == capacity) {
+                        capacity *= 2;
+                        base = realloc(base, sizeof(*base) * capacity);
+                }
+                base[(*count)++] = m;
+        }
+        bool ok = feof(in) && !ferror(in);
+        fclose(in);
+        if (!ok) {
+                free(base);
+                return NULL;
+        }
+        return base;
+}
+static const struct measurement *find_baseline(const struct measurement *m,
+                                               const struct measurement *base,
+                                               size_t num_base) {
+        for (size_t i=0; i<num_base; i++) {
+                if (base[i].num_items == m->num_items
+                    && strcmp(base[i].name, m->name) == 0) {
+                        return base + i;
+                }
+        }
+        return NULL;
+}
+static void print_usage(const char *prog) {
+        fprintf(stderr, "usage: %s [-n max_items] [-s samples] [-w warmup] "
+                "[-b benchmark] [-o baseline_out] "
+                "[-c baseline_in [-t threshold]]\n", prog);
+}
@@ -0,0 +1,37 @@
+/** Implements function prototypes in mono-clock.h
+ * @file mono-clock.c */
+#include "mono-clock.h"
+
+double mono_now(void) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec + now.tv_nsec * 1e-9;
+}
+double mono_now_ns(void) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec * 1e9 + now.tv_nsec;
+}
+double mono_lap(struct timespec *lap) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double seconds = (now.tv_sec - lap->tv_sec)
+                         + (now.tv_nsec - lap->tv_nsec) * 1e-9;
+        *lap = now;
+        return seconds;
+}
+struct timespec mono_after(double seconds) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        double secs = deadline.tv_nsec * 1e-9 + seconds;
+        deadline.tv_sec += (time_t)secs;
+        deadline.tv_nsec = (long)((secs - (time_t)secs) * 1e9);
+        return deadline;
+}
+bool mono_passed(const struct timespec *deadline) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec > deadline->tv_sec
+               || (now.tv_sec == deadline->tv_sec
+                   && now.tv_nsec >= deadline->tv_nsec);
+}
@@ -0,0 +1,23 @@
+#ifndef MONO_CLOCK_H
+#define MONO_CLOCK_H
+/** Header file for readings of CLOCK_MONOTONIC, shared by the time limits
+ * and phase timers of the engine and by the timings of the drivers and
+ * benchmarks
+ * @file mono-clock.h */
+
+#include <stdbool.h>
+#include <time.h>
+
+/** Returns the time in seconds, for subtracting from a later reading */
+double mono_now(void);
+/** Returns the time in nanoseconds, for subtracting from a later reading */
+double mono_now_ns(void);
+/** Returns the seconds elapsed since *lap and restarts *lap at the current
+ * time */
+double mono_lap(struct timespec *lap);
+/** Returns the time seconds from now */
+struct timespec mono_after(double seconds);
+/** Returns whether the clock has reached deadline */
+bool mono_passed(const struct timespec *deadline);
+
+#endif /* !MONO_CLOCK_H */
@@ -2,191 +2,637 @@
  * functions
  * @file number-partition.c */
 #include "number-partition.h"
-#include "population.h"
+#include "ga-engine.h"
+#include "fitness.h"
+#include "differencing.h"
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <pthread.h>
+#include <assert.h>
+#include <math.h>
 
-/** Max number of generations the algorithm will go through before
- * terminating */
-#define MAX_GENS                        100
-/** Scaling factor for population size based on problem instance input size */
-#define POP_SIZE_FACTOR                 1
+/** State shared by all threads of a run */
+struct ga_run {
+        const prob_set_t *ps;
+        const ga_ctx_t *ctx;
+        size_t num_threads;
+        /** Current and next generation; which is which alternates */
+        pop_arena_t *arenas[2];
+        /** Mating pool of indices into the current generation */
+        size_t *pool;
+        /** Best chromosome found so far; only written by thread 0 */
+        chrom_t *best_chrom;
+        size_t num_gens_passed;
+        /** Whether the deadline had passed when thread 0 last checked; only
+         * written by thread 0 between the two barriers of a generation */
+        bool past_deadline;
+        pthread_barrier_t barrier;
+        struct ga_worker *workers;
+};
+/** State private to one thread of a run; each thread owns a contiguous
+ * slice of chromosome indices in every generation */
+struct ga_worker {
+        struct ga_run *run;
+        /** Index of the first chromosome of the slice */
+        size_t lo;
+        /** Index one past the last chromosome of the slice */
+        size_t hi;
+        /** Index of the fittest chromosome of the slice in the current
+         * generation; meaningless if the slice is empty */
+        size_t fittest_i;
+        /** Counters of this thread, summed once the run is over */
+        ga_stats_t stats;
+        /** Allocations made by this thread during the last generation; only
+         * kept while tracing */
+        size_t gen_allocs;
+        pthread_t thread;
+        /** Random stream of this thread; kept on its own cache line */
+        rng_t rng __attribute__((aligned(64)));
+};
 
-/** Return a result structure based on the decidedly-best chromosome */
-static result_t *result_malloc(chrom_t *best_chrom,
-                               const long long *item_vals,
-                               size_t num_gens_passed);
-/** Finds the fittest chromosome in the population and returns its index */
-static size_t find_fittest(const pop_t *pop);
-/** Generates a random initial population of chromosomes and returns it */
-static pop_t *initial_pop(size_t num_chroms, size_t num_bits,
-                          const long long *item_vals);
-/** Compares the fitness of two chromosomes; returns 1 if c2 is more fit,
- * -1 if c1 is more fit, and 0 if both are equally fit */
-static int chrom_fit_cmp(const chrom_t *c1, const chrom_t *c2);
-/** Calculates the fitness of an entire population and modifies the
- * chromosomes' unfitness values accordingly */
-static void pop_calc_fitness(pop_t *pop, const long long *item_vals);
-/** Performs tournament selection and returns a mating pool which _points_ to
- * chromosomes in the initial population
- * @post make sure to pop_free(mating_pool) and to pop_purge(pop) */
-static pop_t *tourn_select(const pop_t *pop);
-/** Generate a new generation to replace the old one using the mating pool for
- * crossover and mutating the offspring */
-static pop_t *new_gen(const pop_t *tourn, const long long *item_vals);
+/** Runs the genetic algorithm over every item of ps */
+static result_t *run_ga(const prob_set_t *ps, const ga_params_t *params,
+                        ga_stats_t *stats);
+/** Reduces ps to num_residual partial partitions, runs the genetic
+ * algorithm over those and returns the partition of ps they stand for */
+static result_t *run_reduced(const prob_set_t *ps, const ga_params_t *params,
+                             size_t num_residual, ga_stats_t *stats);
+/** Body of every thread of a run; thread 0 runs it on the calling thread */
+static void *run_worker(void *ga_worker);
+/** Every thread reduces the fittest chromosomes of all slices of pop, once
+ * all threads have found theirs, to the same best unfitness; thread 0 also
+ * keeps a copy of the chromosome if it beats the best so far. Ties go to the
+ * lowest slice so the result does not depend on timing */
+static void track_best(const struct ga_worker *worker, const pop_arena_t *pop,
+                       long long *best_unfitness);
+/** Completes rec with generation gen, whose population is pop, and the
+ * allocations of every thread, adds it to the trace of the run and clears
+ * its timers for the next generation */
+static void record_gen(const struct ga_run *run, ga_gen_record_t *rec,
+                       size_t gen, const pop_arena_t *pop);
 
-prob_set_t *prob_set_malloc(size_t num_items) {
-        prob_set_t *tmp = malloc(PROB_SET_SIZE(num_items));
-        tmp->num_items = num_items;
-        return tmp;
+void ga_params_init(ga_params_t *params) {
+        params->pop_size_factor = POP_SIZE_FACTOR;
+        params->pop_size_cap = 0;
+        params->memory_budget = 0;
+        params->reduce_items = 0;
+        params->max_gens = MAX_GENS;
+        params->tourn_size = TOURN_SIZE;
+        params->crossover = CROSSOVER_UNIFORM;
+        params->replacement = REPLACEMENT_GENERATIONAL;
+        params->target_diff = 0;
+        params->stall_gens = 0;
+        params->time_limit = 0;
+        params->mutation_rate = 0;
+        params->seed = 0;
+        params->stream = 0;
+        params->num_threads = 1;
+        params->num_islands = 1;
+        params->migration_interval = 10;
+        params->num_migrants = 2;
+        params->delta_fitness = true;
+        params->fixed_width = true;
+        params->seed_fraction = 0;
+        params->local_search_k = 0;
+        params->local_search_budget = 0;
+        params->sorted = NULL;
+        params->trace = NULL;
+}
+
+result_t *num_part_2way(const prob_set_t *ps) {
+        ga_params_t params;
+        ga_params_init(&params);
+        return num_part_2way_params(ps, &params);
 }
-void prob_set_free(prob_set_t *ps) {
-        free(ps);
+result_t *num_part_2way_params(const prob_set_t *ps,
+                               const ga_params_t *params) {
+        return num_part_2way_stats(ps, params, NULL);
 }
-void result_free(result_t *res) {
-        free(res->set0_vals);
-        free(res->set1_vals);
-        free(res);
+result_t *num_part_2way_stats(const prob_set_t *ps,
+                              const ga_params_t *params, ga_stats_t *stats) {
+        size_t num_residual = ga_residual_items(params, ps->num_items);
+        if (num_residual < ps->num_items) {
+                return run_reduced(ps, params, num_residual, stats);
+        }
+        return run_ga(ps, params, stats);
 }
 
-result_t *num_part_2way(const prob_set_t *ps) {
-        chrom_t *best_chrom = chrom_malloc(ps->num_items);
-        best_chrom->unfitness = LLONG_MAX;
-        const size_t pop_size = ps->num_items * POP_SIZE_FACTOR;
-        pop_t *pop = initial_pop(pop_size, ps->num_items, ps->item_vals);
-        size_t num_gen_passed = 1;
-        while ((num_gen_passed < MAX_GENS)
-               && (best_chrom->unfitness != 0)) {
-                pop_t *tourn = tourn_select(pop);
-                pop_t *next_gen = new_gen(tourn, ps->item_vals);
-                pop_free(tourn);
-                pop_purge(pop);
-                pop = next_gen;
-                size_t fittest_i = find_fittest(pop);
-                if (chrom_fit_cmp(best_chrom, pop->chroms[fittest_i]) == 1) {
-                        memcpy(best_chrom, pop->chroms[fittest_i],
-                               CHROM_SIZE(best_chrom->num_bits));
-                }
-                num_gen_passed++;
-        }
-        pop_purge(pop);
-        result_t *res = result_malloc(best_chrom,
-                                      ps->item_vals, num_gen_passed);
-        chrom_free(best_chrom);
+static result_t *run_reduced(const prob_set_t *ps, const ga_params_t *params,
+                             size_t num_residual, ga_stats_t *stats) {
+        ldm_reduction_t *red = ldm_reduce(ps->item_vals, ps->num_items,
+                                          num_residual);
+        /* a sorted index given by the caller is of the original items */
+        ga_params_t residual_params = *params;
+        residual_params.sorted = NULL;
+        result_t *residual_res = run_ga(red->residual, &residual_params,
+                                        stats);
+        chrom_t *chrom = chrom_malloc(ps->num_items);
+        ldm_expand(red, residual_res->words, chrom->words);
+        result_t *res = result_malloc(chrom, ps->item_vals,
+                                      residual_res->num_gens_passed);
+        chrom_free(chrom);
+        result_free(residual_res);
+        ldm_reduction_free(red);
         return res;
 }
-
-struct result_sets_context {
-        const long long *item_vals;
-        long long *set0_vals;
-        long long *set1_vals;
-};
-static void split_result_sets(bool bit_val, void *result_sets_context) {
-        struct result_sets_context *context
-                = (struct result_sets_context *)result_sets_context;
-        if (bit_val == 0) {
-                *context->set0_vals = *context->item_vals;
-                context->set0_vals++;
-        } else {
-                *context->set1_vals = *context->item_vals;
-                context->set1_vals++;
-        }
-        context->item_vals++;
-}
-static void count1s_bits(bool bit_val, void *count) {
-        *(size_t *)count += bit_val;
-}
-static result_t *result_malloc(chrom_t *best_chrom,
-                               const long long *item_vals,
-                               size_t num_gens_passed) {
-        result_t *res = malloc(sizeof(*res));
-        res->num_gens_passed = num_gens_passed;
-        res->set1_count = 0;
-        chrom_bitwise_read(best_chrom, &res->set1_count, count1s_bits);
-        res->set1_vals = malloc(sizeof(*res->set1_vals)*res->set1_count);
-        res->set0_count = best_chrom->num_bits - res->set1_count;
-        res->set0_vals = malloc(sizeof(*res->set0_vals)*res->set0_count);
-        struct result_sets_context context = {item_vals, res->set0_vals,
-                                              res->set1_vals};
-        chrom_bitwise_read(best_chrom, &context, split_result_sets);
+static result_t *run_ga(const prob_set_t *ps, const ga_params_t *params,
+                        ga_stats_t *stats) {
+        ga_ctx_t ctx;
+        ga_ctx_init(&ctx, ps, params);
+        if (params->replacement == REPLACEMENT_STEADY_STATE) {
+                result_t *res = num_part_2way_steady(ps, params, &ctx,
+                                                     stats);
+                ga_ctx_free(&ctx);
+                return res;
+        }
+        if (params->num_islands > 1) {
+                result_t *res = num_part_2way_islands(ps, params, &ctx,
+                                                      stats);
+                ga_ctx_free(&ctx);
+                return res;
+        }
+        result_t *fixed_res = num_part_2way_fixed(ps, params, &ctx, stats);
+        if (fixed_res != NULL) {
+                ga_ctx_free(&ctx);
+                return fixed_res;
+        }
+        const size_t pop_size = ctx.pop_size;
+        const size_t num_threads = (params->num_threads > 0)
+                                   ? params->num_threads
+                                   : 1;
+        /* every allocation of the run happens here; generations alternate
+         * between the two arenas */
+        struct ga_run run = {
+                .ps = ps,
+                .ctx = &ctx,
+                .num_threads = num_threads,
+                .arenas = {pop_arena_malloc(pop_size, ps->num_items),
+                           pop_arena_malloc(pop_size, ps->num_items)},
+                .pool = ga_malloc(sizeof(size_t) * pop_size),
+                .best_chrom = chrom_malloc(ps->num_items),
+                .past_deadline = false,
+                .workers = ga_malloc(sizeof(struct ga_worker) * num_threads)
+        };
+        run.best_chrom->unfitness = LLONG_MAX;
+        pthread_barrier_init(&run.barrier, NULL, num_threads);
+        /* thread t uses the t-th jump of the run's stream, so the result
+         * only depends on the seed, the stream and the thread count */
+        rng_t rng;
+        rng_seed_stream(&rng, params->seed, params->stream);
+        for (size_t t=0; t<num_threads; t++) {
+                struct ga_worker *worker = run.workers + t;
+                worker->run = &run;
+                worker->lo = pop_size * t / num_threads;
+                worker->hi = pop_size * (t + 1) / num_threads;
+                worker->stats = (ga_stats_t){0};
+                worker->rng = rng;
+                rng_jump(&rng);
+        }
+        for (size_t t=1; t<num_threads; t++) {
+                pthread_create(&run.workers[t].thread, NULL, run_worker,
+                               run.workers + t);
+        }
+        run_worker(run.workers);
+        for (size_t t=1; t<num_threads; t++) {
+                pthread_join(run.workers[t].thread, NULL);
+        }
+        pthread_barrier_destroy(&run.barrier);
+        if (stats != NULL) {
+                *stats = (ga_stats_t){0};
+                for (size_t t=0; t<num_threads; t++) {
+                        ga_stats_add(stats, &run.workers[t].stats);
+                }
+        }
+        free(run.workers);
+        free(run.pool);
+        pop_arena_free(run.arenas[0]);
+        pop_arena_free(run.arenas[1]);
+        result_t *res = result_malloc(run.best_chrom, ps->item_vals,
+                                      run.num_gens_passed);
+        chrom_free(run.best_chrom);
+        ga_ctx_free(&ctx);
         return res;
 }
-static size_t find_fittest(const pop_t *pop) {
-        size_t fittest_i = 0;
-        for (size_t i=1; i<pop->num_chroms; i++) {
-                if (chrom_fit_cmp(pop->chroms[fittest_i],
-                                  pop->chroms[i]) == 1) {
+
+/* Each generation has two phases separated by barriers: selection fills the
+ * mating pool, then breeding reads the whole pool to fill the next
+ * generation. After the second barrier every thread reads the slice bests
+ * and reaches the same decision on its own, so no third barrier is needed;
+ * thread 0 copies the best chromosome, which is safe since that generation
+ * is not overwritten until after the next selection barrier. Ties are
+ * broken by the lowest index so the outcome does not depend on timing */
+static void *run_worker(void *ga_worker) {
+        struct ga_worker *worker = (struct ga_worker *)ga_worker;
+        struct ga_run *run = worker->run;
+        /* only the first thread times its phases and makes the records,
+         * once every thread has counted its allocations */
+        ga_gen_record_t rec = {0};
+        double *timers = (run->ctx->trace != NULL && worker == run->workers)
+                         ? rec.phase_seconds
+                         : NULL;
+        struct timespec lap;
+        size_t cur = 0;
+        long long best_unfitness = LLONG_MAX;
+        size_t num_allocs = ga_num_allocs;
+        initial_pop(run->arenas[cur], worker->lo, worker->hi, run->ctx,
+                    &worker->rng);
+        worker->fittest_i = find_fittest(run->arenas[cur], worker->lo,
+                                         worker->hi);
+        worker->gen_allocs = ga_num_allocs - num_allocs;
+        pthread_barrier_wait(&run->barrier);
+        track_best(worker, run->arenas[cur], &best_unfitness);
+        if (timers != NULL) {
+                record_gen(run, &rec, 0, run->arenas[cur]);
+        }
+        size_t num_gens_passed = 1;
+        size_t stall_gens = 0;
+        while (!ga_converged(run->ctx, num_gens_passed, best_unfitness,
+                             stall_gens)
+               && !run->past_deadline) {
+                pop_arena_t *pop = run->arenas[cur];
+                pop_arena_t *next = run->arenas[!cur];
+                num_allocs = ga_num_allocs;
+                ga_lap_start(timers, &lap);
+                tourn_select(pop, run->pool, worker->lo, worker->hi,
+                             run->ctx, &worker->rng);
+                ga_lap(timers, GA_PHASE_SELECT, &lap);
+                pthread_barrier_wait(&run->barrier);
+                ga_lap(timers, GA_PHASE_SYNC, &lap);
+                new_gen(pop, run->pool, next, worker->lo, worker->hi,
+                        run->ctx, &worker->rng, &worker->stats, timers);
+                ga_lap_start(timers, &lap);
+                worker->fittest_i = find_fittest(next, worker->lo,
+                                                 worker->hi);
+                if (worker == run->workers) {
+                        run->past_deadline = ga_past_deadline(run->ctx);
+                }
+                worker->gen_allocs = ga_num_allocs - num_allocs;
+                ga_lap(timers, GA_PHASE_FITTEST, &lap);
+                pthread_barrier_wait(&run->barrier);
+                ga_lap(timers, GA_PHASE_SYNC, &lap);
+                cur = !cur;
+                long long prev_unfitness = best_unfitness;
+                track_best(worker, next, &best_unfitness);
+                ga_lap(timers, GA_PHASE_FITTEST, &lap);
+                stall_gens = (best_unfitness < prev_unfitness)
+                             ? 0
+                             : stall_gens + 1;
+                if (timers != NULL) {
+                        record_gen(run, &rec, num_gens_passed, next);
+                }
+                num_gens_passed++;
+        }
+        if (worker == run->workers) {
+                run->num_gens_passed = num_gens_passed;
+        }
+        return NULL;
+}
+static void record_gen(const struct ga_run *run, ga_gen_record_t *rec,
+                       size_t gen, const pop_arena_t *pop) {
+        /* the other threads wrote their counts before the last barrier and
+         * cannot write them again before the next one */
+        rec->gen = gen;
+        rec->island = 0;
+        ga_record_pop(rec, pop, run->ctx);
+        rec->num_allocs = 0;
+        for (size_t t=0; t<run->num_threads; t++) {
+                rec->num_allocs += run->workers[t].gen_allocs;
+        }
+        ga_trace_add(run->ctx->trace, rec);
+        for (size_t p=0; p<GA_NUM_PHASES; p++) {
+                rec->phase_seconds[p] = 0;
+        }
+}
+static void track_best(const struct ga_worker *worker, const pop_arena_t *pop,
+                       long long *best_unfitness) {
+        struct ga_run *run = worker->run;
+        size_t fittest_i = SIZE_MAX;
+        for (size_t t=0; t<run->num_threads; t++) {
+                const struct ga_worker *other = run->workers + t;
+                if (other->lo == other->hi) {
+                        continue;
+                }
+                if (fittest_i == SIZE_MAX
+                    || (pop->unfitness[other->fittest_i]
+                        < pop->unfitness[fittest_i])) {
+                        fittest_i = other->fittest_i;
+                }
+        }
+        if (pop->unfitness[fittest_i] < *best_unfitness) {
+                *best_unfitness = pop->unfitness[fittest_i];
+                if (worker == run->workers) {
+                        run->best_chrom->unfitness = *best_unfitness;
+                        memcpy(run->best_chrom->words,
+                               ARENA_CHROM(pop, fittest_i),
+                               sizeof(uint64_t) * pop->stride);
+                }
+        }
+}
+
+void ga_ctx_init(ga_ctx_t *ctx, const prob_set_t *ps,
+                 const ga_params_t *params) {
+        ctx->item_vals = ps->item_vals;
+        ctx->num_items = ps->num_items;
+        ctx->pop_size = ga_pop_size(params, ps->num_items);
+        ctx->max_gens = params->max_gens;
+        ctx->tourn_size = (params->tourn_size > 0) ? params->tourn_size : 1;
+        ctx->crossover = params->crossover;
+        ctx->width = fitness_width(ps->item_vals, ps->num_items);
+        ctx->key_shift = fitness_key_shift(ps->item_vals, ps->num_items);
+        ctx->target_diff = (params->target_diff > 0)
+                           ? fitness_key(params->target_diff, ctx->key_shift)
+                           : params->target_diff;
+        ctx->stall_gens = params->stall_gens;
+        ctx->has_deadline = params->time_limit > 0;
+        ctx->deadline = mono_after(ctx->has_deadline ? params->time_limit
+                                                     : 0);
+        ctx->total = fitness_sum(ps->item_vals, ps->num_items);
+        ctx->mutation_rate = (params->mutation_rate > 0)
+                             ? params->mutation_rate
+                             : 1.0 / ps->num_items;
+        /* the parents' differences are only exact for narrow instances */
+        ctx->delta_fitness = params->delta_fitness
+                             && ctx->width == FITNESS_NARROW;
+        ctx->seed_fraction = params->seed_fraction;
+        /* moves are scored with the long long differences of the arena */
+        ctx->ls_top_k = (ctx->width == FITNESS_NARROW)
+                        ? params->local_search_k
+                        : 0;
+        ctx->ls_budget = params->local_search_budget;
+        ctx->sorted = params->sorted;
+        ctx->owned_sorted = NULL;
+        ctx->trace = params->trace;
+        if (ctx->sorted == NULL
+            && (ctx->seed_fraction > 0 || ctx->ls_top_k > 0)) {
+                ctx->owned_sorted = sort_items(ps->item_vals, ps->num_items);
+                ctx->sorted = ctx->owned_sorted;
+        }
+}
+size_t ga_pop_size(const ga_params_t *params, size_t num_items) {
+        double pop_size = num_items * params->pop_size_factor;
+        if (params->pop_size_cap > 0 && pop_size > params->pop_size_cap) {
+                pop_size = sqrt(pop_size * params->pop_size_cap);
+        }
+        size_t size = (size_t)(pop_size + 0.5);
+        if (params->memory_budget > 0) {
+                size_t max_size = params->memory_budget
+                                  / GA_CHROM_BYTES(num_items);
+                if (size > max_size) {
+                        size = max_size;
+                }
+        }
+        return (size > 0) ? size : 1;
+}
+size_t ga_residual_items(const ga_params_t *params, size_t num_items) {
+        size_t num_residual = num_items;
+        if (params->reduce_items > 0 && num_residual > params->reduce_items) {
+                num_residual = params->reduce_items;
+        }
+        if (params->memory_budget > 0) {
+                /* the most words per chromosome for which BUDGET_MIN_POP
+                 * chromosomes fit */
+                size_t chrom_bytes = params->memory_budget / BUDGET_MIN_POP;
+                size_t max_words = (chrom_bytes > GA_CHROM_BYTES(0))
+                                   ? (chrom_bytes - GA_CHROM_BYTES(0))
+                                     / (2 * sizeof(uint64_t))
+                                   : 0;
+                if (BITS2WORDS(num_residual) > max_words) {
+                        num_residual = max_words * WORD_BITS;
+                }
+        }
+        return (num_residual > 0 || num_items == 0) ? num_residual : 1;
+}
+void ga_ctx_free(ga_ctx_t *ctx) {
+        free(ctx->owned_sorted);
+}
+bool ga_converged(const ga_ctx_t *ctx, size_t num_gens_passed,
+                  long long best_unfitness, size_t stall_gens) {
+        return num_gens_passed >= ctx->max_gens
+               || best_unfitness <= ctx->target_diff
+               || (ctx->stall_gens > 0 && stall_gens >= ctx->stall_gens);
+}
+bool ga_past_deadline(const ga_ctx_t *ctx) {
+        return ctx->has_deadline && mono_passed(&ctx->deadline);
+}
+void ga_stats_add(ga_stats_t *dst, const ga_stats_t *src) {
+        dst->ls_chroms += src->ls_chroms;
+        dst->ls_improved += src->ls_improved;
+        dst->ls_moves += src->ls_moves;
+        dst->ls_swaps += src->ls_swaps;
+        dst->ls_gain += src->ls_gain;
+        dst->ls_budget_hits += src->ls_budget_hits;
+        dst->ls_seconds += src->ls_seconds;
+}
+size_t find_fittest(const pop_arena_t *pop, size_t lo, size_t hi) {
+        size_t fittest_i = lo;
+        for (size_t i=lo+1; i<hi; i++) {
+                if (pop->unfitness[i] < pop->unfitness[fittest_i]) {
                         fittest_i = i;
                 }
         }
         return fittest_i;
 }
-static pop_t *initial_pop(size_t num_chroms, size_t num_bits,
-                          const long long *item_vals) {
-        pop_t *pop = pop_rand(num_chroms, num_bits);
-        pop_calc_fitness(pop, item_vals);
-        return pop;
+void initial_pop(pop_arena_t *pop, size_t lo, size_t hi,
+                 const ga_ctx_t *ctx, rng_t *rng) {
+        size_t num_seeds = (size_t)(ctx->seed_fraction * pop->num_chroms
+                                    + 0.5);
+        for (size_t i=lo; i<hi; i++) {
+                if (i < num_seeds) {
+                        seed_chrom(ARENA_CHROM(pop, i), i, ctx, rng);
+                        continue;
+                }
+                words_rand(ARENA_CHROM(pop, i), pop->num_bits, rng);
+                words_normalize(ARENA_CHROM(pop, i), pop->num_bits);
+        }
+        pop_calc_fitness(pop, lo, hi, ctx);
+}
+/** Stores a difference of a FITNESS_WIDE instance as its fitness_key, with
+ * the sign of the difference */
+static void set_wide_diff(pop_arena_t *pop, size_t i, __int128 diff,
+                          unsigned key_shift) {
+        long long key = fitness_key((diff < 0) ? -(unsigned __int128)diff
+                                               : (unsigned __int128)diff,
+                                    key_shift);
+        pop->diff[i] = (diff < 0) ? -key : key;
+        pop->unfitness[i] = key;
 }
-static int chrom_fit_cmp(const chrom_t *c1, const chrom_t *c2) {
-        if (c1->unfitness < c2->unfitness) {
-                return -1;
-        } else if (c1->unfitness > c2->unfitness) {
-                return 1;
-        } else {
-                return 0;
+void calc_fitness_group(pop_arena_t *pop, const size_t *indices,
+                        size_t group_size, const ga_ctx_t *ctx) {
+        const uint64_t *group[FITNESS_GROUP] = {NULL};
+        for (size_t c=0; c<group_size; c++) {
+                group[c] = ARENA_CHROM(pop, indices[c]);
+        }
+        if (ctx->width == FITNESS_WIDE) {
+                __int128 wide_diffs[FITNESS_GROUP];
+                fitness_diff_batch_wide(group, group_size, ctx->item_vals,
+                                        pop->num_bits, ctx->total,
+                                        wide_diffs);
+                for (size_t c=0; c<group_size; c++) {
+                        set_wide_diff(pop, indices[c], wide_diffs[c],
+                                      ctx->key_shift);
+                }
+                return;
+        }
+        long long diffs[FITNESS_GROUP];
+        fitness_diff_batch(group, group_size, ctx->item_vals, pop->num_bits,
+                           (long long)ctx->total, diffs);
+        for (size_t c=0; c<group_size; c++) {
+                pop->diff[indices[c]] = diffs[c];
+                pop->unfitness[indices[c]] = (diffs[c] < 0)
+                                             ? -diffs[c]
+                                             : diffs[c];
         }
 }
-struct fitness_context {
-        const long long *item_vals;
-        long long unfitness;
-};
-static void bit_calc_fitness(bool bit_val, void *fitness_context) {
-        struct fitness_context *context
-                = (struct fitness_context *)fitness_context;
-        if (bit_val) {
-                context->unfitness -= *context->item_vals;
-        } else {
-                context->unfitness += *context->item_vals;
-        }
-        context->item_vals++;
-}
-static void chrom_calc_fitness(chrom_t *chrom, const long long *item_vals) {
-        struct fitness_context context = {item_vals, 0};
-        chrom_bitwise_read(chrom, &context, bit_calc_fitness);
-        if (context.unfitness < 0) {
-                chrom->unfitness = -context.unfitness;
-        } else {
-                chrom->unfitness = context.unfitness;
-        }
-}
-static void pop_calc_fitness(pop_t *pop, const long long *item_vals) {
-        for (size_t i=0; i<pop->num_chroms; i++) {
-                chrom_calc_fitness(pop->chroms[i], item_vals);
-        }
-}
-static pop_t *tourn_select(const pop_t *pop) {
-        pop_t *tourn = pop_malloc(pop->num_chroms);
-        for (size_t i=0; i<tourn->num_chroms; i++) {
-                size_t i1 = rand() % pop->num_chroms;
-                size_t i2 = rand() % pop->num_chroms;
-                if (chrom_fit_cmp(pop->chroms[i1], pop->chroms[i2]) == 1) {
-                        tourn->chroms[i] = pop->chroms[i2];
-                } else {
-                        tourn->chroms[i] = pop->chroms[i1];
-                }
-        }
-        return tourn;
-}
-static pop_t *new_gen(const pop_t *tourn, const long long *item_vals) {
-        pop_t *new_gen = pop_malloc(tourn->num_chroms);
-        for (size_t i=0; i<new_gen->num_chroms; i++) {
-                size_t p1i = rand() % tourn->num_chroms;
-                size_t p2i = rand() % tourn->num_chroms;
-                new_gen->chroms[i] = chrom_ucx(tourn->chroms[p1i],
-                                               tourn->chroms[p2i]);
-                chrom_mutate(new_gen->chroms[i]);
-        }
-        pop_calc_fitness(new_gen, item_vals);
-        return new_gen;
+void pop_calc_fitness(pop_arena_t *pop, size_t lo, size_t hi,
+                      const ga_ctx_t *ctx) {
+        for (size_t i=lo; i<hi; i+=FITNESS_GROUP) {
+                size_t group_size = (hi - i < FITNESS_GROUP)
+                                    ? hi - i
+                                    : FITNESS_GROUP;
+                size_t indices[FITNESS_GROUP];
+                for (size_t c=0; c<group_size; c++) {
+                        indices[c] = i + c;
+                }
+                calc_fitness_group(pop, indices, group_size, ctx);
+        }
+}
+/** Defines NAME, filling entries [lo, hi) of the mating pool with the
+ * winners of tournaments of SIZE chromosomes; instantiated with constant
+ * sizes so that the draws of the common tournaments are unrolled */
+#define DEFINE_TOURN_SELECT(NAME, SIZE)                                       \
+static void NAME(const pop_arena_t *pop, size_t *pool, size_t lo, size_t hi,  \
+                 size_t tourn_size, rng_t *rng) {                             \
+        /* only read by the instance whose SIZE is tourn_size itself */       \
+        (void)tourn_size;                                                     \
+        for (size_t i=lo; i<hi; i++) {                                        \
+                size_t winner = rng_below(rng, pop->num_chroms);              \
+                for (size_t k=1; k<(SIZE); k++) {                             \
+                        size_t other = rng_below(rng, pop->num_chroms);       \
+                        if (pop->unfitness[winner] > pop->unfitness[other]) { \
+                                winner = other;                               \
+                        }                                                     \
+                }                                                             \
+                pool[i] = winner;                                             \
+        }                                                                     \
+}
+DEFINE_TOURN_SELECT(tourn_select_2, 2)
+DEFINE_TOURN_SELECT(tourn_select_3, 3)
+DEFINE_TOURN_SELECT(tourn_select_4, 4)
+DEFINE_TOURN_SELECT(tourn_select_any, tourn_size)
+
+void tourn_select(const pop_arena_t *pop, size_t *pool,
+                  size_t lo, size_t hi, const ga_ctx_t *ctx, rng_t *rng) {
+        switch (ctx->tourn_size) {
+        case 2:
+                tourn_select_2(pop, pool, lo, hi, 2, rng);
+                break;
+        case 3:
+                tourn_select_3(pop, pool, lo, hi, 3, rng);
+                break;
+        case 4:
+                tourn_select_4(pop, pool, lo, hi, 4, rng);
+                break;
+        default:
+                tourn_select_any(pop, pool, lo, hi, ctx->tourn_size, rng);
+                break;
+        }
+}
+bool child_diff_from_parents(const pop_arena_t *pop, size_t p1i,
+                             size_t p2i, const uint64_t *child,
+                             const ga_ctx_t *ctx, long long *diff) {
+        size_t num_bits = pop->num_bits;
+        size_t parents[2] = {p1i, p2i};
+        size_t base_i = p1i;
+        bool base_inverted = false;
+        size_t min_dist = SIZE_MAX;
+        for (size_t p=0; p<2; p++) {
+                size_t dist = words_distance(child,
+                                             ARENA_CHROM(pop, parents[p]),
+                                             num_bits);
+                if (dist < min_dist) {
+                        min_dist = dist;
+                        base_i = parents[p];
+                        base_inverted = false;
+                }
+                if (num_bits - dist < min_dist) {
+                        min_dist = num_bits - dist;
+                        base_i = parents[p];
+                        base_inverted = true;
+                }
+        }
+        if (min_dist > num_bits / DELTA_FITNESS_DIV) {
+                return false;
+        }
+        *diff = fitness_diff_from(child, ARENA_CHROM(pop, base_i),
+                                  pop->diff[base_i], base_inverted,
+                                  ctx->item_vals, num_bits);
+        return true;
+}
+void new_gen(const pop_arena_t *pop, const size_t *pool,
+             pop_arena_t *next, size_t lo, size_t hi,
+             const ga_ctx_t *ctx, rng_t *rng, ga_stats_t *stats,
+             double *phase_seconds) {
+        struct timespec lap;
+        ga_lap_start(phase_seconds, &lap);
+        /* offspring too far from their parents are evaluated together once
+         * a full group has been collected */
+        size_t pending[FITNESS_GROUP];
+        size_t num_pending = 0;
+        size_t num_misses = 0;
+        for (size_t i=lo; i<hi; i++) {
+                size_t p1i = pool[rng_below(rng, pop->num_chroms)];
+                size_t p2i = pool[rng_below(rng, pop->num_chroms)];
+                uint64_t *child = ARENA_CHROM(next, i);
+                const uint64_t *p1 = ARENA_CHROM(pop, p1i);
+                const uint64_t *p2 = ARENA_CHROM(pop, p2i);
+                switch (ctx->crossover) {
+                case CROSSOVER_ONE_POINT:
+                        words_1px(child, p1, p2, next->num_bits, rng);
+                        break;
+                case CROSSOVER_TWO_POINT:
+                        words_2px(child, p1, p2, next->num_bits, rng);
+                        break;
+                default:
+                        words_ucx(child, p1, p2, next->num_bits, rng);
+                        break;
+                }
+                words_normalize(child, next->num_bits);
+                words_mutate(child, next->num_bits, ctx->mutation_rate, rng);
+                words_normalize(child, next->num_bits);
+                long long diff;
+                bool try_delta = ctx->delta_fitness
+                                 && num_misses < DELTA_FITNESS_PROBES;
+                if (try_delta && !child_diff_from_parents(pop, p1i, p2i,
+                                                          child, ctx,
+                                                          &diff)) {
+                        num_misses++;
+                        try_delta = false;
+                }
+                if (try_delta) {
+                        num_misses = 0;
+#ifdef FITNESS_CHECK
+                        assert(diff == fitness_diff(child, ctx->item_vals,
+                                                    ctx->num_items,
+                                                    (long long)ctx->total));
+#endif
+                        next->diff[i] = diff;
+                        next->unfitness[i] = (diff < 0) ? -diff : diff;
+                        continue;
+                }
+                pending[num_pending++] = i;
+                if (num_pending == FITNESS_GROUP) {
+                        ga_lap(phase_seconds, GA_PHASE_BREED, &lap);
+                        calc_fitness_group(next, pending, num_pending, ctx);
+                        ga_lap(phase_seconds, GA_PHASE_FITNESS, &lap);
+                        num_pending = 0;
+                }
+        }
+        ga_lap(phase_seconds, GA_PHASE_BREED, &lap);
+        if (num_pending > 0) {
+                calc_fitness_group(next, pending, num_pending, ctx);
+                ga_lap(phase_seconds, GA_PHASE_FITNESS, &lap);
+        }
+        local_search(next, lo, hi, ctx, stats);
+        ga_lap(phase_seconds, GA_PHASE_LOCAL_SEARCH, &lap);
 }
@@ -4,7 +4,10 @@
  * genetic algorithm
  * @file number-partition.h */
 
+#include "result.h"
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 /** Helper macro to know the size of a problem set structure */
 #define PROB_SET_SIZE(NUM_ITEMS) \
@@ -15,23 +18,175 @@ struct problem_set {
         size_t num_items;
         long long item_vals[];
 };
-typedef struct result result_t;
-/** Return structure of num_part_2way */
-struct result {
-        size_t num_gens_passed;
-        size_t set0_count;
-        long long *set0_vals;
-        size_t set1_count;
-        long long *set1_vals;
+typedef enum crossover crossover_t;
+/** Crossover operators breeding each offspring from two parents */
+enum crossover {
+        /** Each bit from either parent with equal probability */
+        CROSSOVER_UNIFORM,
+        /** Bits below a random cut from one parent, the rest from the
+         * other */
+        CROSSOVER_ONE_POINT,
+        /** Bits between two random cuts from one parent, the rest from the
+         * other */
+        CROSSOVER_TWO_POINT
+};
+typedef enum replacement replacement_t;
+/** How offspring replace the population */
+enum replacement {
+        /** Every generation, a whole population of offspring replaces the
+         * previous one; only a copy of the best chromosome is kept */
+        REPLACEMENT_GENERATIONAL,
+        /** Each offspring replaces the least fit chromosome in place as soon
+         * as it is bred, if it is fitter and not a duplicate of a
+         * chromosome already in the population, so the best chromosomes are
+         * never lost */
+        REPLACEMENT_STEADY_STATE
+};
+/** Telemetry collector of a run, declared in ga-trace.h */
+typedef struct ga_trace ga_trace_t;
+typedef struct ga_params ga_params_t;
+/** Tunable parameters of a single num_part_2way_params run; initialize with
+ * ga_params_init before changing individual fields */
+struct ga_params {
+        /** Population size as a multiple of the number of items; split
+         * evenly between islands */
+        double pop_size_factor;
+        /** Populations that pop_size_factor would make larger than this
+         * many chromosomes only grow as the square root of the number of
+         * items beyond it: the size is the geometric mean of the two; 0
+         * means no cap */
+        size_t pop_size_cap;
+        /** Bytes the populations and mating pools of the run may take; 0
+         * means no limit. The population shrinks to fit, and an instance
+         * too large for even BUDGET_MIN_POP chromosomes (ga-engine.h) to
+         * fit is reduced first, as by reduce_items */
+        size_t memory_budget;
+        /** Instances of more items than this are first reduced by the
+         * Largest Differencing Method to this many partial partitions, which
+         * fixes the largest items on opposite sides, and the search only
+         * partitions those; 0 means never */
+        size_t reduce_items;
+        /** Max number of generations, counting the initial population */
+        size_t max_gens;
+        /** Number of chromosomes drawn per tournament, the fittest of which
+         * enters the mating pool; 0 means 1 */
+        size_t tourn_size;
+        /** Operator breeding offspring from their parents */
+        crossover_t crossover;
+        /** How offspring replace the population; the steady-state engine
+         * runs a single population on the calling thread, without local
+         * search, whatever num_threads and num_islands are. A generation of
+         * it is as many offspring as there are chromosomes */
+        replacement_t replacement;
+        /** The run stops once the best difference is at most this; with
+         * islands, the other islands stop at the next migration */
+        long long target_diff;
+        /** The run stops after this many generations in a row without a
+         * better best difference (per island); 0 means never */
+        size_t stall_gens;
+        /** Wall-clock seconds after which the run stops at the end of the
+         * current generation; 0 means none. A run stopped by it is not
+         * reproducible from its seed */
+        double time_limit;
+        /** Probability of each bit being flipped during mutation; 0 means
+         * 1/num_items, an average of 1 bit per chromosome */
+        double mutation_rate;
+        /** Seed of the random number generator; equal seeds and streams
+         * reproduce a run bit for bit */
+        uint64_t seed;
+        /** Index of the independent random stream of seed to use, so that
+         * several runs can share one seed without sharing random numbers */
+        uint64_t stream;
+        /** Number of threads sharing the work of each generation; results
+         * are deterministic for a given seed, stream and thread count */
+        size_t num_threads;
+        /** Number of islands; above 1 the population is split into this many
+         * sub-populations, each evolving on its own thread (num_threads is
+         * then unused) */
+        size_t num_islands;
+        /** Number of generations between migrations between islands */
+        size_t migration_interval;
+        /** Number of best chromosomes each island sends to the next one per
+         * migration, replacing that island's worst */
+        size_t num_migrants;
+        /** Whether offspring are evaluated incrementally from their parents'
+         * differences when they are close enough to one of them */
+        bool delta_fitness;
+        /** Whether runs over at most 1024 items use the engines specialized
+         * for fixed chromosome widths when they support the other
+         * parameters; results are the same either way */
+        bool fixed_width;
+        /** Fraction of the initial population seeded from heuristics rather
+         * than drawn at random: the Largest Differencing Method's partition,
+         * the sorted greedy partition and then greedy partitions over
+         * randomly perturbed orders; 0 seeds none */
+        double seed_fraction;
+        /** Number of fittest offspring of each generation (of each island)
+         * improved by steepest descent over single-item moves and pairwise
+         * swaps between the sets before the next selection; 0 disables the
+         * stage. Unused for instances whose sum of absolute item values
+         * exceeds a long long */
+        size_t local_search_k;
+        /** Wall-clock seconds each thread or island may spend on local
+         * search per generation; 0 means none. A run whose budget runs out
+         * is no longer reproducible from its seed */
+        double local_search_budget;
+        /** Item indices by decreasing value, ties by index, if already known
+         * (e.g. from a problem file); NULL has the run sort the items when
+         * it needs them. Not freed by the run */
+        const size_t *sorted;
+        /** Collects per-phase timers, per-generation statistics and
+         * allocation counts of the run if not NULL (see ga-trace.h); results
+         * are the same either way. Not freed by the run */
+        ga_trace_t *trace;
+};
+typedef struct ga_stats ga_stats_t;
+/** Counters of a num_part_2way_stats run */
+struct ga_stats {
+        /** Offspring passed through local search */
+        size_t ls_chroms;
+        /** Offspring whose unfitness local search lowered */
+        size_t ls_improved;
+        /** Single items moved from one set to the other */
+        size_t ls_moves;
+        /** Pairs of items swapped between the sets */
+        size_t ls_swaps;
+        /** Sum over all offspring of the unfitness local search removed */
+        double ls_gain;
+        /** Generations of a thread or island whose local search budget ran
+         * out */
+        size_t ls_budget_hits;
+        /** Seconds spent in local search, summed over threads and islands */
+        double ls_seconds;
 };
 
-/** Returns a problem set structure to pass to num_part_2way */
+/** Returns a problem set structure to pass to num_part_2way; defined in
+ * prob-io.c along with the readers, so that programs which only read
+ * problem sets need not link the genetic algorithm
+ * @post                item values are uninitialized
+ * @post                problem set must be freed (via prob_set_free) */
 prob_set_t *prob_set_malloc(size_t num_items);
 /** Frees a problem set structure from the heap */
 void prob_set_free(prob_set_t *ps);
-/** Frees a result structure returned by num_part_2way */
-void result_free(result_t *res);
+/** Returns the indices of num_items items by decreasing value, ties by
+ * index; defined in prob-io.c too, as problem files store this order
+ * @post                array must be freed (via free) */
+size_t *sort_items(const long long *item_vals, size_t num_items);
+
+/** Fills params with the defaults used by num_part_2way */
+void ga_params_init(ga_params_t *params);
+/** Adds the counters of src to those of dst, e.g. to total several runs */
+void ga_stats_add(ga_stats_t *dst, const ga_stats_t *src);
 
+/** Runs the genetic algorithm with the default parameters */
 result_t *num_part_2way(const prob_set_t *ps);
+/** Runs the genetic algorithm with the given parameters */
+result_t *num_part_2way_params(const prob_set_t *ps,
+                               const ga_params_t *params);
+/** Runs the genetic algorithm with the given parameters, also counting what
+ * its stages did
+ * @param stats         filled in if not NULL */
+result_t *num_part_2way_stats(const prob_set_t *ps,
+                              const ga_params_t *params, ga_stats_t *stats);
 
 #endif /* !NUMBER_PARTITION_H */
@@ -0,0 +1,171 @@
+/** Implements function prototypes in out-buf.h
+ * @file out-buf.c */
+#include "out-buf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+/** Capacity of a buffer's first allocation */
+#define OUT_BUF_MIN_CAP         4096
+/** Most decimal digits of a 128-bit integer, plus its sign */
+#define INT128_CHARS            40
+/** Largest power of ten that fits in a uint64_t, and its exponent */
+#define POW10_19                10000000000000000000ULL
+#define POW10_19_DIGITS         19
+
+/** "00" to "99", so that digits are produced two at a time */
+static const char digit_pairs[201] =
+        "00010203040506070809101112131415161718192021222324252627282930313233"
+        "34353637383940414243444546474849505152535455565758596061626364656667"
+        "6869707172737475767778798081828384858687888990919293949596979899";
+
+/** Writes the decimal digits of val so that they end just before end, at
+ * least min_digits of them (zero-padded); returns the number written */
+static size_t format_u64(char *end, uint64_t val, size_t min_digits);
+/** Same as format_u64 without padding, for 128-bit values */
+static size_t format_u128(char *end, unsigned __int128 val);
+/** Same as format_u128 for signed values, minus sign included */
+static size_t format_i128(char *end, __int128 val);
+
+void out_buf_init(out_buf_t *buf) {
+        buf->data = NULL;
+        buf->len = 0;
+        buf->cap = 0;
+}
+void out_buf_free(out_buf_t *buf) {
+        free(buf->data);
+        out_buf_init(buf);
+}
+void out_buf_reserve(out_buf_t *buf, size_t len) {
+        if (buf->cap - buf->len >= len) {
+                return;
+        }
+        size_t cap = (buf->cap > 0) ? buf->cap : OUT_BUF_MIN_CAP;
+        while (cap - buf->len < len) {
+                cap *= 2;
+        }
+        buf->data = realloc(buf->data, cap);
+        buf->cap = cap;
+}
+void out_buf_bytes(out_buf_t *buf, const char *bytes, size_t len) {
+        /* an empty buffer has no data to copy into yet */
+        if (len == 0) {
+                return;
+        }
+        out_buf_reserve(buf, len);
+        memcpy(buf->data + buf->len, bytes, len);
+        buf->len += len;
+}
+void out_buf_str(out_buf_t *buf, const char *str) {
+        out_buf_bytes(buf, str, strlen(str));
+}
+void out_buf_char(out_buf_t *buf, char c) {
+        out_buf_reserve(buf, 1);
+        buf->data[buf->len++] = c;
+}
+void out_buf_ll(out_buf_t *buf, long long val) {
+        char digits[INT128_CHARS];
+        char *end = digits + sizeof(digits);
+        /* the magnitude of the most negative value only fits unsigned */
+        unsigned long long mag = (val < 0) ? -(unsigned long long)val
+                                           : (unsigned long long)val;
+        size_t len = format_u64(end, mag, 1);
+        if (val < 0) {
+                *(end - ++len) = '-';
+        }
+        out_buf_bytes(buf, end - len, len);
+}
+void out_buf_ull(out_buf_t *buf, unsigned long long val) {
+        char digits[INT128_CHARS];
+        char *end = digits + sizeof(digits);
+        size_t len = format_u64(end, val, 1);
+        out_buf_bytes(buf, end - len, len);
+}
+void out_buf_int128(out_buf_t *buf, __int128 val) {
+        char digits[INT128_CHARS];
+        char *end = digits + sizeof(digits);
+        size_t len = format_i128(end, val);
+        out_buf_bytes(buf, end - len, len);
+}
+void out_buf_uint128(out_buf_t *buf, unsigned __int128 val) {
+        char digits[INT128_CHARS];
+        char *end = digits + sizeof(digits);
+        size_t len = format_u128(end, val);
+        out_buf_bytes(buf, end - len, len);
+}
+void out_buf_printf(out_buf_t *buf, const char *format, ...) {
+        va_list args;
+        va_start(args, format);
+        va_list copy;
+        va_copy(copy, args);
+        int len = vsnprintf(NULL, 0, format, copy);
+        va_end(copy);
+        if (len > 0) {
+                /* vsnprintf writes a NUL past the text, which len does not
+                 * count */
+                out_buf_reserve(buf, (size_t)len + 1);
+                vsnprintf(buf->data + buf->len, (size_t)len + 1, format,
+                          args);
+                buf->len += len;
+        }
+        va_end(args);
+}
+bool fprint_int128(FILE *out, __int128 val) {
+        char digits[INT128_CHARS];
+        char *end = digits + sizeof(digits);
+        size_t len = format_i128(end, val);
+        return fwrite(end - len, 1, len, out) == len;
+}
+bool out_buf_flush(out_buf_t *buf, FILE *out) {
+        /* data is still NULL if nothing was ever appended */
+        if (buf->len == 0) {
+                return true;
+        }
+        bool ok = fwrite(buf->data, 1, buf->len, out) == buf->len;
+        buf->len = 0;
+        return ok;
+}
+
+static size_t format_u64(char *end, uint64_t val, size_t min_digits) {
+        char *p = end;
+        while (val >= 100) {
+                size_t pair = (val % 100) * 2;
+                val /= 100;
+                p -= 2;
+                p[0] = digit_pairs[pair];
+                p[1] = digit_pairs[pair + 1];
+        }
+        if (val >= 10) {
+                p -= 2;
+                p[0] = digit_pairs[val * 2];
+                p[1] = digit_pairs[val * 2 + 1];
+        } else {
+                *--p = (char)('0' + val);
+        }
+        while ((size_t)(end - p) < min_digits) {
+                *--p = '0';
+        }
+        return end - p;
+}
+static size_t format_u128(char *end, unsigned __int128 val) {
+        /* 64-bit divisions are far cheaper than 128-bit ones, so the value
+         * is split into 19-digit chunks that each fit in a uint64_t */
+        size_t len = 0;
+        while (val > UINT64_MAX) {
+                uint64_t chunk = (uint64_t)(val % POW10_19);
+                val /= POW10_19;
+                len += format_u64(end - len, chunk, POW10_19_DIGITS);
+        }
+        return len + format_u64(end - len, (uint64_t)val, 1);
+}
+static size_t format_i128(char *end, __int128 val) {
+        /* the magnitude of the most negative value only fits unsigned */
+        unsigned __int128 mag = (val < 0) ? -(unsigned __int128)val
+                                          : (unsigned __int128)val;
+        size_t len = format_u128(end, mag);
+        if (val < 0) {
+                *(end - ++len) = '-';
+        }
+        return len;
+}
@@ -0,0 +1,53 @@
+#ifndef OUT_BUF_H
+#define OUT_BUF_H
+/** Header file for a growable output buffer with hand-rolled integer
+ * formatting, for output made of many numbers where one printf call per
+ * value would dominate the run time
+ * @file out-buf.h */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+typedef struct out_buf out_buf_t;
+/** Bytes appended so far; data is not NUL-terminated */
+struct out_buf {
+        char *data;
+        size_t len;
+        size_t cap;
+};
+
+/** Initializes an empty buffer
+ * @post                buf must be freed (via out_buf_free) */
+void out_buf_init(out_buf_t *buf);
+/** Frees the bytes of buf; buf itself is not freed */
+void out_buf_free(out_buf_t *buf);
+/** Makes room for at least len more bytes, so that appending them needs no
+ * reallocation */
+void out_buf_reserve(out_buf_t *buf, size_t len);
+/** Appends len bytes */
+void out_buf_bytes(out_buf_t *buf, const char *bytes, size_t len);
+/** Appends a NUL-terminated string */
+void out_buf_str(out_buf_t *buf, const char *str);
+/** Appends a single character */
+void out_buf_char(out_buf_t *buf, char c);
+/** Appends an integer in decimal */
+void out_buf_ll(out_buf_t *buf, long long val);
+/** Appends an unsigned integer in decimal */
+void out_buf_ull(out_buf_t *buf, unsigned long long val);
+/** Appends a 128-bit integer in decimal; printf has no conversion for it */
+void out_buf_int128(out_buf_t *buf, __int128 val);
+/** Appends an unsigned 128-bit integer in decimal */
+void out_buf_uint128(out_buf_t *buf, unsigned __int128 val);
+/** Appends text formatted as by printf, for the few values (floating point
+ * ones) not worth formatting by hand */
+void out_buf_printf(out_buf_t *buf, const char *format, ...)
+        __attribute__((format(printf, 2, 3)));
+/** Writes a 128-bit integer in decimal straight to out, for output of only a
+ * few such values; returns false on a write error */
+bool fprint_int128(FILE *out, __int128 val);
+/** Writes the contents of buf to out and empties buf; returns false on a
+ * write error */
+bool out_buf_flush(out_buf_t *buf, FILE *out);
+
+#endif /* !OUT_BUF_H */
@@ -0,0 +1,80 @@
+/** Times parsing problem sets with prob_set_parse against one scanf per
+ * value, as the drivers did before prob-io.h, and checks that both agree
+ * @file parse-bench.c */
+#include "prob-io.h"
+#include "rng.h"
+#include "mono-clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/** Number of times each parser runs; the fastest run is reported */
+#define NUM_RUNS                3
+
+/* Usage: parse-bench.out [num_items]
+ * Generates num_items values (default 2000000) of every magnitude up to
+ * that of the "rand" datasets, some negative */
+int main(int argc, char **argv) {
+        size_t num_items = (argc > 1) ? strtoul(argv[1], NULL, 0) : 2000000;
+        rng_t rng;
+        rng_seed(&rng, 1);
+        char *text;
+        size_t len;
+        FILE *out = open_memstream(&text, &len);
+        fprintf(out, "%zu\n", num_items);
+        for (size_t i=0; i<num_items; i++) {
+                /* the number of digits is spread evenly */
+                long long val = rng_next(&rng) >> (1 + rng_below(&rng, 63));
+                if (rng_below(&rng, 8) == 0) {
+                        val = -val;
+                }
+                fprintf(out, "%lld ", val);
+        }
+        fclose(out);
+        double mb = len / 1e6;
+        double scanf_s = 1e30;
+        double parse_s = 1e30;
+        prob_set_t *expected = NULL;
+        prob_set_t *ps = NULL;
+        for (size_t r=0; r<NUM_RUNS; r++) {
+                prob_set_free(expected);
+                double t0 = mono_now();
+                FILE *in = fmemopen(text, len, "r");
+                size_t count;
+                if (fscanf(in, " %zu", &count) != 1) {
+                        return 1;
+                }
+                expected = prob_set_malloc(count);
+                for (size_t i=0; i<count; i++) {
+                        if (fscanf(in, " %lld", expected->item_vals+i) != 1) {
+                                return 1;
+                        }
+                }
+                fclose(in);
+                double t1 = mono_now();
+                if (t1 - t0 < scanf_s) {
+                        scanf_s = t1 - t0;
+                }
+                prob_set_free(ps);
+                t0 = mono_now();
+                ps = prob_set_parse(text, len, NULL);
+                t1 = mono_now();
+                if (t1 - t0 < parse_s) {
+                        parse_s = t1 - t0;
+                }
+        }
+        bool same = ps != NULL && ps->num_items == expected->num_items
+                    && memcmp(ps->item_vals, expected->item_vals,
+                              sizeof(long long) * ps->num_items) == 0;
+        printf("%10s %10s %12s %12s %9s %6s\n",
+               "items", "MB", "scanf MB/s", "parse MB/s", "speedup", "same");
+        printf("%10zu %10.1f %12.1f %12.1f %9.1f %6s\n", num_items, mb,
+               mb / scanf_s, mb / parse_s, scanf_s / parse_s,
+               same ? "yes" : "NO");
+        prob_set_free(ps);
+        prob_set_free(expected);
+        free(text);
+        return 0;
+}
+
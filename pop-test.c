@@ -1,15 +1,20 @@
 #include "population.h"
 #include <stdio.h>
+#include <time.h>
 
 #define NUM_RAND_POPS           10
 #define NUM_CHROM               10
 #define NUM_ITEMS               10
+#define NUM_ARENA_CHROM         10
+#define ARENA_NUM_ITEMS         70
 
 void print_population(const pop_t *pop);
 
 int main(void) {
+        rng_t rng;
+        rng_seed(&rng, time(NULL));
         for (size_t i=0; i<NUM_RAND_POPS; i++) {
-                pop_t *tmp = pop_rand(NUM_CHROM, NUM_ITEMS);
+                pop_t *tmp = pop_rand(NUM_CHROM, NUM_ITEMS, &rng);
                 printf("random population #%zu:\n", i);
                 print_population(tmp);
                 printf("making copy of population #%zu\n", i);
@@ -26,6 +31,14 @@ int main(void) {
                 printf("purging original population\n");
                 pop_purge(tmp);
         }
+        printf("random arena population:\n");
+        pop_arena_t *arena = pop_arena_malloc(NUM_ARENA_CHROM,
+                                              ARENA_NUM_ITEMS);
+        pop_arena_rand(arena, &rng);
+        pop_t *exported = pop_arena_export(arena);
+        print_population(exported);
+        pop_purge(exported);
+        pop_arena_free(arena);
         return 0;
 }
 
@@ -1,15 +1,16 @@
 #include "population.h"
 #include <stdlib.h>
+#include <string.h>
 
 pop_t *pop_malloc(size_t num_chroms) {
         pop_t *tmp = malloc(POP_SIZE + sizeof(chrom_t *) * num_chroms);
         tmp->num_chroms = num_chroms;
         return tmp;
 }
-pop_t *pop_rand(size_t num_chroms, size_t num_bits) {
+pop_t *pop_rand(size_t num_chroms, size_t num_bits, rng_t *rng) {
         pop_t *tmp = pop_malloc(num_chroms);
         for (size_t i=0; i<num_chroms; i++) {
-                tmp->chroms[i] = chrom_rand(num_bits);
+                tmp->chroms[i] = chrom_rand(num_bits, rng);
         }
         return tmp;
 }
@@ -23,3 +24,41 @@ void pop_purge(pop_t *pop) {
         }
         pop_free(pop);
 }
+
+pop_arena_t *pop_arena_malloc(size_t num_chroms, size_t num_bits) {
+        pop_arena_t *tmp = malloc(sizeof(*tmp));
+        tmp->num_chroms = num_chroms;
+        tmp->num_bits = num_bits;
+        tmp->stride = BITS2WORDS(num_bits);
+        tmp->unfitness = malloc(sizeof(*tmp->unfitness) * num_chroms);
+        tmp->diff = malloc(sizeof(*tmp->diff) * num_chroms);
+        size_t words_size = sizeof(*tmp->words) * tmp->stride * num_chroms;
+        /* aligned_alloc requires a size that is a multiple of the
+         * alignment */
+        words_size = (words_size + ARENA_ALIGN - 1)
+                     / ARENA_ALIGN * ARENA_ALIGN;
+        tmp->words = aligned_alloc(ARENA_ALIGN, words_size);
+        return tmp;
+}
+void pop_arena_rand(pop_arena_t *arena, rng_t *rng) {
+        for (size_t i=0; i<arena->num_chroms; i++) {
+                words_rand(ARENA_CHROM(arena, i), arena->num_bits, rng);
+                words_normalize(ARENA_CHROM(arena, i), arena->num_bits);
+        }
+}
+void pop_arena_free(pop_arena_t *arena) {
+        free(arena->words);
+        free(arena->unfitness);
+        free(arena->diff);
+        free(arena);
+}
+pop_t *pop_arena_export(const pop_arena_t *arena) {
+        pop_t *tmp = pop_malloc(arena->num_chroms);
+        for (size_t i=0; i<arena->num_chroms; i++) {
+                tmp->chroms[i] = chrom_malloc(arena->num_bits);
+                tmp->chroms[i]->unfitness = arena->unfitness[i];
+                memcpy(tmp->chroms[i]->words, ARENA_CHROM(arena, i),
+                       sizeof(uint64_t) * arena->stride);
+        }
+        return tmp;
+}
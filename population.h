@@ -21,10 +21,10 @@ struct population {
  * @post                population must be freed (via pop_free) */
 pop_t *pop_malloc(size_t num_chroms);
 /** Returns a population containing num_chromosomes number of randomized
- * chromosomes where each chromosome holds num_bits random bits
+ * chromosomes where each chromosome holds num_bits random bits drawn from rng
  * @post                each chromosome will have be freed (via pop_purge)
  * @post                population will have to be freed (via pop_purge) */
-pop_t *pop_rand(size_t num_chroms, size_t num_bits);
+pop_t *pop_rand(size_t num_chroms, size_t num_bits, rng_t *rng);
 
 /** Frees memory allocated for population; does not free chromosomes
  * @post                any space allocated for chromosomes remains allocated
@@ -35,4 +35,48 @@ void pop_free(pop_t *pop);
  *                      dereferenced */
 void pop_purge(pop_t *pop);
 
+/** Alignment in bytes of an arena's word block */
+#define ARENA_ALIGN     64
+/** Macro to get the word array of the I-th chromosome of an arena */
+#define ARENA_CHROM(ARENA, I) \
+        ((ARENA)->words + (I) * (ARENA)->stride)
+typedef struct pop_arena pop_arena_t;
+/** Population stored as a structure of arrays: the bits of every chromosome
+ * live in one contiguous block at a fixed stride, in the chromosome word
+ * layout, and unfitness values live in a parallel array; chromosomes are
+ * referred to by index */
+struct pop_arena {
+        /** Number of chromosomes in population */
+        size_t num_chroms;
+        /** Number of bits in each chromosome */
+        size_t num_bits;
+        /** Number of words from the start of one chromosome to the next */
+        size_t stride;
+        /** Unfitness of each chromosome; uninitialized when allocated */
+        long long *unfitness;
+        /** Signed difference (sum of set0 - sum of set1) of each chromosome,
+         * whose absolute value is its unfitness; kept so that offspring can
+         * be evaluated from their parents' differences; uninitialized when
+         * allocated */
+        long long *diff;
+        /** Bits of all chromosomes */
+        uint64_t *words;
+};
+
+/** Returns an arena that holds num_chroms chromosomes of num_bits bits
+ * @post                bits, unfitness values and differences are
+ *                      uninitialized
+ * @post                arena must be freed (via pop_arena_free) */
+pop_arena_t *pop_arena_malloc(size_t num_chroms, size_t num_bits);
+/** Fills every chromosome of the arena with random bits drawn from rng
+ * @post                leading bit of every chromosome is 0
+ * @post                unfitness values and differences are left untouched */
+void pop_arena_rand(pop_arena_t *arena, rng_t *rng);
+/** Frees the arena along with all of its chromosome data */
+void pop_arena_free(pop_arena_t *arena);
+/** Returns a population holding a separately allocated copy of each
+ * chromosome of the arena, unfitness included, for use with the pop_t API
+ * @post                population must be purged (via pop_purge) */
+pop_t *pop_arena_export(const pop_arena_t *arena);
+
 #endif /* !POPULATION_H */
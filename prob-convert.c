@@ -0,0 +1,146 @@
+/** Converts problem sets between the text format and binary problem files
+ * @file prob-convert.c */
+#include "prob-file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/** Prints the values of each set of the result file at path, written for
+ * ps; returns the exit status */
+int print_result_file(const char *path, const prob_set_t *ps);
+
+/* Usage: prob-convert.out [-v] text_in bin_out
+ *        prob-convert.out -d [-v] [-r result_file] bin_in
+ * The first form writes a binary problem file (prob-file.h) from a problem
+ * set in the text format; "-" reads stdin. -d instead prints a binary file
+ * back in the text format, or with -r the values of each set of a result
+ * file written for it. -v verifies the binary file written or read */
+int main(int argc, char **argv) {
+        bool dump = false;
+        bool verify = false;
+        const char *result_path = NULL;
+        int opt;
+        while ((opt = getopt(argc, argv, "dvr:")) != -1) {
+                switch (opt) {
+                case 'd':
+                        dump = true;
+                        break;
+                case 'v':
+                        verify = true;
+                        break;
+                case 'r':
+                        result_path = optarg;
+                        break;
+                default:
+                        fprintf(stderr, "usage: %s [-v] text_in bin_out\n"
+                                "       %s -d [-v] [-r result_file] bin_in\n",
+                                argv[0],
+                                argv[0]);
+                        return 1;
+                }
+        }
+        prob_io_status_t status;
+        if (dump) {
+                if (optind + 1 != argc) {
+                        fprintf(stderr, "%s: -d takes one file\n", argv[0]);
+                        return 1;
+                }
+                prob_file_t *pf = prob_file_map(argv[optind], verify,
+                                                &status);
+                if (pf == NULL) {
+                        fprintf(stderr, "%s: %s\n", argv[optind],
+                                prob_io_strerror(status));
+                        return 1;
+                }
+                if (result_path != NULL) {
+                        int ret = print_result_file(result_path, pf->ps);
+                        prob_file_unmap(pf);
+                        return ret;
+                }
+                printf("%zu\n", pf->ps->num_items);
+                for (size_t i=0; i<pf->ps->num_items; i++) {
+                        printf("%lld ", pf->ps->item_vals[i]);
+                }
+                putchar('\n');
+                prob_file_unmap(pf);
+                return 0;
+        }
+        if (optind + 2 != argc) {
+                fprintf(stderr, "%s: expected an input and an output file\n",
+                        argv[0]);
+                return 1;
+        }
+        const char *in_path = argv[optind];
+        const char *out_path = argv[optind + 1];
+        FILE *in = (strcmp(in_path, "-") == 0) ? stdin : fopen(in_path, "r");
+        if (in == NULL) {
+                perror(in_path);
+                return 1;
+        }
+        prob_set_t *ps = prob_set_read(in, &status);
+        if (in != stdin) {
+                fclose(in);
+        }
+        if (ps == NULL) {
+                fprintf(stderr, "%s: %s\n", in_path,
+                        prob_io_strerror(status));
+                return 1;
+        }
+        FILE *out = fopen(out_path, "wb");
+        if (out == NULL) {
+                perror(out_path);
+                prob_set_free(ps);
+                return 1;
+        }
+        status = prob_file_write(out, ps);
+        if (fclose(out) != 0 && status == PROB_IO_OK) {
+                status = PROB_IO_WRITE_ERROR;
+        }
+        if (status == PROB_IO_OK && verify) {
+                prob_file_t *pf = prob_file_map(out_path, true, &status);
+                if (pf != NULL) {
+                        if (pf->ps->num_items != ps->num_items
+                            || memcmp(pf->ps->item_vals, ps->item_vals,
+                                      sizeof(long long) * ps->num_items)
+                               != 0) {
+                                status = PROB_IO_BAD_CHECKSUM;
+                        }
+                        prob_file_unmap(pf);
+                }
+        }
+        prob_set_free(ps);
+        if (status != PROB_IO_OK) {
+                fprintf(stderr, "%s: %s\n", out_path,
+                        prob_io_strerror(status));
+                return 1;
+        }
+        return 0;
+}
+
+int print_result_file(const char *path, const prob_set_t *ps) {
+        FILE *in = fopen(path, "rb");
+        if (in == NULL) {
+                perror(path);
+                return 1;
+        }
+        prob_io_status_t status;
+        result_t *res = result_file_read(in, ps, &status);
+        fclose(in);
+        if (res == NULL) {
+                fprintf(stderr, "%s: %s\n", path, prob_io_strerror(status));
+                return 1;
+        }
+        for (unsigned set=0; set<2; set++) {
+                printf("set%u:\n", set);
+                result_iter_t it;
+                result_iter_init(&it, res, set);
+                long long val;
+                while (result_iter_next(&it, &val)) {
+                        printf("%lld ", val);
+                }
+                putchar('\n');
+        }
+        result_free(res);
+        return 0;
+}
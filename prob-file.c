@@ -0,0 +1,260 @@
+/** Implements function prototypes in prob-file.h
+ * @file prob-file.c */
+#include "prob-file.h"
+#include "fitness.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define PROB_FILE_MAGIC                 "NPPROB\r\n"
+#define PROB_FILE_VERSION               1
+#define RESULT_FILE_MAGIC               "NPRSLT\r\n"
+#define RESULT_FILE_VERSION             1
+/** Alignment of the items and the sorted index within a problem file */
+#define PROB_FILE_ALIGN                 64
+
+_Static_assert(sizeof(prob_file_header_t) <= PROB_FILE_HEADER_SIZE,
+               "problem file header overflows its space");
+_Static_assert(sizeof(size_t) == sizeof(uint64_t),
+               "the sorted index is mapped as size_t");
+
+/** Rounds n up to a multiple of PROB_FILE_ALIGN */
+static uint64_t align_up(uint64_t n);
+/** Fills the offsets and size of a header for num_items items */
+static void layout(prob_file_header_t *header, uint64_t num_items);
+/** Returns whether sorted lists every item of ps once, by decreasing value
+ * and then by index */
+static bool sorted_valid(const prob_set_t *ps, const size_t *sorted);
+
+uint64_t prob_set_checksum(const prob_set_t *ps) {
+        /* FNV-1a over whole values, then a final avalanche */
+        uint64_t hash = 0xcbf29ce484222325ULL ^ ps->num_items;
+        for (size_t i=0; i<ps->num_items; i++) {
+                hash = (hash ^ (uint64_t)ps->item_vals[i])
+                       * 0x100000001b3ULL;
+        }
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash;
+}
+prob_io_status_t prob_file_write(FILE *out, const prob_set_t *ps) {
+        prob_file_header_t header = {0};
+        memcpy(header.magic, PROB_FILE_MAGIC, sizeof(header.magic));
+        header.version = PROB_FILE_VERSION;
+        header.value_width = sizeof(long long);
+        header.num_items = ps->num_items;
+        header.checksum = prob_set_checksum(ps);
+        __int128 total = fitness_sum(ps->item_vals, ps->num_items);
+        header.total_lo = (uint64_t)total;
+        header.total_hi = (int64_t)(total >> 64);
+        for (size_t i=0; i<ps->num_items; i++) {
+                long long val = ps->item_vals[i];
+                if (i == 0 || val > header.max_val) {
+                        header.max_val = val;
+                }
+                if (i == 0 || val < header.min_val) {
+                        header.min_val = val;
+                }
+        }
+        layout(&header, ps->num_items);
+        size_t *sorted = sort_items(ps->item_vals, ps->num_items);
+        /* the header, then zeros up to the set, then the set, zeros and the
+         * index */
+        static const char zeros[PROB_FILE_HEADER_SIZE + PROB_FILE_ALIGN];
+        uint64_t set_end = header.set_offset
+                           + PROB_SET_SIZE(ps->num_items);
+        bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+                  && fwrite(zeros, 1, header.set_offset - sizeof(header),
+                            out) == header.set_offset - sizeof(header)
+                  && fwrite(ps, PROB_SET_SIZE(ps->num_items), 1, out) == 1
+                  && fwrite(zeros, 1, header.sorted_offset - set_end, out)
+                     == header.sorted_offset - set_end
+                  && fwrite(sorted, sizeof(*sorted), ps->num_items, out)
+                     == ps->num_items;
+        free(sorted);
+        return ok ? PROB_IO_OK : PROB_IO_WRITE_ERROR;
+}
+prob_file_t *prob_file_map(const char *path, bool verify,
+                           prob_io_status_t *status) {
+        prob_io_status_t dummy;
+        if (status == NULL) {
+                status = &dummy;
+        }
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+                *status = PROB_IO_READ_ERROR;
+                return NULL;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+                close(fd);
+                *status = PROB_IO_READ_ERROR;
+                return NULL;
+        }
+        if ((uint64_t)st.st_size < PROB_FILE_HEADER_SIZE) {
+                close(fd);
+                *status = PROB_IO_BAD_FORMAT;
+                return NULL;
+        }
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+                *status = PROB_IO_READ_ERROR;
+                return NULL;
+        }
+        const prob_file_header_t *header = map;
+        prob_file_header_t expected = {0};
+        layout(&expected, header->num_items);
+        const prob_set_t *ps = (const prob_set_t *)((const char *)map
+                                                    + header->set_offset);
+        /* the layout is recomputed from the count rather than trusted, so
+         * the count is bounded first to keep that from overflowing */
+        bool valid = memcmp(header->magic, PROB_FILE_MAGIC,
+                            sizeof(header->magic)) == 0
+                     && header->version == PROB_FILE_VERSION
+                     && header->value_width == sizeof(long long)
+                     && header->num_items <= (uint64_t)st.st_size / 16
+                     && header->set_offset == expected.set_offset
+                     && header->sorted_offset == expected.sorted_offset
+                     && header->file_size == expected.file_size
+                     && header->file_size == (uint64_t)st.st_size
+                     && ps->num_items == header->num_items;
+        if (!valid) {
+                munmap(map, st.st_size);
+                *status = PROB_IO_BAD_FORMAT;
+                return NULL;
+        }
+        const size_t *sorted = (const size_t *)((const char *)map
+                                                + header->sorted_offset);
+        /* the engine indexes the items by the sorted index, so it is
+         * checked on every load; a corrupt one is a malformed file */
+        if (!sorted_valid(ps, sorted)) {
+                munmap(map, st.st_size);
+                *status = PROB_IO_BAD_FORMAT;
+                return NULL;
+        }
+        if (verify && prob_set_checksum(ps) != header->checksum) {
+                munmap(map, st.st_size);
+                *status = PROB_IO_BAD_CHECKSUM;
+                return NULL;
+        }
+        prob_file_t *pf = malloc(sizeof(*pf));
+        pf->ps = ps;
+        pf->sorted = sorted;
+        pf->total = ((__int128)header->total_hi << 64) | header->total_lo;
+        pf->max_val = header->max_val;
+        pf->min_val = header->min_val;
+        pf->checksum = header->checksum;
+        pf->map = map;
+        pf->map_size = st.st_size;
+        *status = PROB_IO_OK;
+        return pf;
+}
+void prob_file_unmap(prob_file_t *pf) {
+        munmap(pf->map, pf->map_size);
+        free(pf);
+}
+prob_io_status_t result_file_write(FILE *out, const result_t *res,
+                                   const prob_set_t *ps) {
+        result_file_header_t header = {0};
+        memcpy(header.magic, RESULT_FILE_MAGIC, sizeof(header.magic));
+        header.version = RESULT_FILE_VERSION;
+        header.num_items = res->num_items;
+        header.prob_checksum = prob_set_checksum(ps);
+        header.num_gens_passed = res->num_gens_passed;
+        header.set1_count = res->set1_count;
+        header.set0_sum_lo = (uint64_t)res->set0_sum;
+        header.set0_sum_hi = (int64_t)(res->set0_sum >> 64);
+        header.set1_sum_lo = (uint64_t)res->set1_sum;
+        header.set1_sum_hi = (int64_t)(res->set1_sum >> 64);
+        size_t num_words = BITS2WORDS(res->num_items);
+        bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+                  && fwrite(res->words, sizeof(uint64_t), num_words, out)
+                     == num_words;
+        return ok ? PROB_IO_OK : PROB_IO_WRITE_ERROR;
+}
+result_t *result_file_read(FILE *in, const prob_set_t *ps,
+                           prob_io_status_t *status) {
+        prob_io_status_t dummy;
+        if (status == NULL) {
+                status = &dummy;
+        }
+        result_file_header_t header;
+        if (fread(&header, sizeof(header), 1, in) != 1
+            || memcmp(header.magic, RESULT_FILE_MAGIC,
+                      sizeof(header.magic)) != 0
+            || header.version != RESULT_FILE_VERSION) {
+                *status = PROB_IO_BAD_FORMAT;
+                return NULL;
+        }
+        if (header.num_items != ps->num_items
+            || header.prob_checksum != prob_set_checksum(ps)) {
+                *status = PROB_IO_BAD_CHECKSUM;
+                return NULL;
+        }
+        chrom_t *chrom = chrom_malloc(ps->num_items);
+        size_t num_words = BITS2WORDS(ps->num_items);
+        if (fread(chrom->words, sizeof(uint64_t), num_words, in)
+            != num_words) {
+                chrom_free(chrom);
+                *status = PROB_IO_BAD_FORMAT;
+                return NULL;
+        }
+        /* padding bits must be clear, as everywhere in the chromosome
+         * layout */
+        if (num_words != 0 && (chrom->words[num_words - 1]
+                               & ~TAIL_MASK(ps->num_items))) {
+                chrom_free(chrom);
+                *status = PROB_IO_BAD_CHECKSUM;
+                return NULL;
+        }
+        result_t *res = result_malloc(chrom, ps->item_vals,
+                                      header.num_gens_passed);
+        chrom_free(chrom);
+        /* the stored counts and sums must match the bitmap */
+        if (res->set1_count != header.set1_count
+            || res->set1_sum != (((__int128)header.set1_sum_hi << 64)
+                                 | header.set1_sum_lo)) {
+                result_free(res);
+                *status = PROB_IO_BAD_CHECKSUM;
+                return NULL;
+        }
+        *status = PROB_IO_OK;
+        return res;
+}
+
+static uint64_t align_up(uint64_t n) {
+        return (n + PROB_FILE_ALIGN - 1) / PROB_FILE_ALIGN * PROB_FILE_ALIGN;
+}
+static void layout(prob_file_header_t *header, uint64_t num_items) {
+        uint64_t vals_offset = offsetof(prob_set_t, item_vals);
+        header->set_offset = align_up(PROB_FILE_HEADER_SIZE + vals_offset)
+                             - vals_offset;
+        header->sorted_offset = align_up(header->set_offset + vals_offset
+                                         + sizeof(long long) * num_items);
+        header->file_size = header->sorted_offset
+                            + sizeof(uint64_t) * num_items;
+}
+static bool sorted_valid(const prob_set_t *ps, const size_t *sorted) {
+        bool *seen = calloc(ps->num_items, sizeof(*seen));
+        bool valid = true;
+        for (size_t k=0; k<ps->num_items && valid; k++) {
+                size_t i = sorted[k];
+                valid = i < ps->num_items && !seen[i];
+                if (valid && k > 0) {
+                        size_t prev = sorted[k - 1];
+                        valid = ps->item_vals[prev] > ps->item_vals[i]
+                                || (ps->item_vals[prev] == ps->item_vals[i]
+                                    && prev < i);
+                }
+                if (valid) {
+                        seen[i] = true;
+                }
+        }
+        free(seen);
+        return valid;
+}
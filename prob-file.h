@@ -0,0 +1,108 @@
+#ifndef PROB_FILE_H
+#define PROB_FILE_H
+/** Header file for the binary problem set and result file formats
+ *
+ * A problem file is a PROB_FILE_HEADER_SIZE byte header followed, at
+ * header.set_offset, by the exact memory layout of a prob_set_t (the item
+ * count, then the items, which start on a 64-byte boundary), and at
+ * header.sorted_offset by the item indices by decreasing value as
+ * sort_items orders them. Mapping the file therefore gives a prob_set_t
+ * without copying anything. A result file is a header followed by the
+ * membership bitmap in the chromosome layout. Both are in the byte order of
+ * the machine that wrote them; files of the other order are rejected.
+ * @file prob-file.h */
+
+#include "number-partition.h"
+#include "prob-io.h"
+#include <stdio.h>
+
+/** Size of the header of a problem file */
+#define PROB_FILE_HEADER_SIZE           128
+
+typedef struct prob_file_header prob_file_header_t;
+/** Header of a problem file */
+struct prob_file_header {
+        /** PROB_FILE_MAGIC */
+        char magic[8];
+        /** PROB_FILE_VERSION, also telling the byte order apart */
+        uint32_t version;
+        /** Bytes per item value; always sizeof(long long) */
+        uint32_t value_width;
+        uint64_t num_items;
+        /** prob_set_checksum of the items */
+        uint64_t checksum;
+        /** Low and high halves of the sum of all items */
+        uint64_t total_lo;
+        int64_t total_hi;
+        /** Largest and smallest item; 0 if there are none */
+        int64_t max_val;
+        int64_t min_val;
+        /** File offset of the prob_set_t */
+        uint64_t set_offset;
+        /** File offset of the sorted index of num_items uint64_t */
+        uint64_t sorted_offset;
+        /** Total size of the file */
+        uint64_t file_size;
+};
+typedef struct prob_file prob_file_t;
+/** Read-only view of a mapped problem file */
+struct prob_file {
+        /** Problem set inside the mapping */
+        const prob_set_t *ps;
+        /** Item indices by decreasing value, ties by index */
+        const size_t *sorted;
+        __int128 total;
+        long long max_val;
+        long long min_val;
+        uint64_t checksum;
+        void *map;
+        size_t map_size;
+};
+typedef struct result_file_header result_file_header_t;
+/** Header of a result file, followed by BITS2WORDS(num_items) words */
+struct result_file_header {
+        /** RESULT_FILE_MAGIC */
+        char magic[8];
+        /** RESULT_FILE_VERSION, also telling the byte order apart */
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t num_items;
+        /** Checksum of the problem set the result partitions */
+        uint64_t prob_checksum;
+        uint64_t num_gens_passed;
+        uint64_t set1_count;
+        /** Low and high halves of the sums of each set */
+        uint64_t set0_sum_lo;
+        int64_t set0_sum_hi;
+        uint64_t set1_sum_lo;
+        int64_t set1_sum_hi;
+};
+
+/** Returns a checksum of the items of ps, mixing whole values rather than
+ * bytes so that it runs at memory speed */
+uint64_t prob_set_checksum(const prob_set_t *ps);
+/** Writes ps to out as a problem file, sorting its items for the index */
+prob_io_status_t prob_file_write(FILE *out, const prob_set_t *ps);
+/** Maps the problem file at path read-only. The sorted index is always
+ * checked to list every item once in order, since it is used to index the
+ * items; with verify set the checksum of the items is also checked. Each
+ * costs a pass over its part of the file. Returns NULL with status (if not
+ * NULL) telling why on failure
+ * @post                result must be freed (via prob_file_unmap) */
+prob_file_t *prob_file_map(const char *path, bool verify,
+                           prob_io_status_t *status);
+/** Unmaps a problem file; its ps and sorted are no longer valid after */
+void prob_file_unmap(prob_file_t *pf);
+
+/** Writes res, a partition of ps, to out as a result file
+ * @pre                 res->num_items == ps->num_items */
+prob_io_status_t result_file_write(FILE *out, const result_t *res,
+                                   const prob_set_t *ps);
+/** Reads a result file written for ps, which must outlive the result;
+ * returns NULL with status (if not NULL) telling why if the
+ * file is malformed or was written for another problem set
+ * @post                result must be freed (via result_free) */
+result_t *result_file_read(FILE *in, const prob_set_t *ps,
+                           prob_io_status_t *status);
+
+#endif /* !PROB_FILE_H */
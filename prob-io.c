@@ -0,0 +1,253 @@
+/** Implements function prototypes in prob-io.h
+ * @file prob-io.c */
+#include "prob-io.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+/** Smallest buffer prob_set_read grows from when the input size is unknown */
+#define READ_CHUNK              65536
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define HAVE_SWAR_DIGITS        1
+#else
+#define HAVE_SWAR_DIGITS        0
+#endif
+
+/** Item value paired with its index for sorting */
+struct sort_entry {
+        long long val;
+        size_t i;
+};
+
+/** Orders entries by decreasing value, ties by index */
+static int entry_cmp(const void *a, const void *b);
+/** Returns whether c separates integers */
+static bool is_separator(char c);
+/** Parses the unsigned integer at text[*pos], advancing *pos past it;
+ * returns PROB_IO_BAD_VALUE if there is no digit or PROB_IO_OVERFLOW if it
+ * exceeds max */
+static prob_io_status_t parse_magnitude(const char *text, size_t len,
+                                        size_t *pos, unsigned long long max,
+                                        unsigned long long *out);
+/** Returns whether the 8 bytes of chunk (in memory order) are all ASCII
+ * digits */
+static bool is_eight_digits(uint64_t chunk);
+/** Returns the value of the 8 ASCII digits of chunk, first in memory being
+ * most significant */
+static uint32_t eight_digits_value(uint64_t chunk);
+
+prob_set_t *prob_set_malloc(size_t num_items) {
+        prob_set_t *tmp = malloc(PROB_SET_SIZE(num_items));
+        tmp->num_items = num_items;
+        return tmp;
+}
+void prob_set_free(prob_set_t *ps) {
+        free(ps);
+}
+size_t *sort_items(const long long *item_vals, size_t num_items) {
+        struct sort_entry *entries = malloc(sizeof(*entries) * num_items);
+        for (size_t i=0; i<num_items; i++) {
+                entries[i].val = item_vals[i];
+                entries[i].i = i;
+        }
+        qsort(entries, num_items, sizeof(*entries), entry_cmp);
+        size_t *sorted = malloc(sizeof(*sorted) * num_items);
+        for (size_t i=0; i<num_items; i++) {
+                sorted[i] = entries[i].i;
+        }
+        free(entries);
+        return sorted;
+}
+prob_set_t *prob_set_parse(const char *text, size_t len,
+                           prob_io_status_t *status) {
+        prob_io_status_t dummy;
+        if (status == NULL) {
+                status = &dummy;
+        }
+        size_t pos = 0;
+        while (pos < len && is_separator(text[pos])) {
+                pos++;
+        }
+        unsigned long long count;
+        *status = parse_magnitude(text, len, &pos, SIZE_MAX, &count);
+        if (*status != PROB_IO_OK) {
+                if (*status == PROB_IO_BAD_VALUE) {
+                        *status = PROB_IO_BAD_COUNT;
+                }
+                return NULL;
+        }
+        /* every value takes a digit and a separator, so a count the text
+         * cannot hold is rejected before allocating for it */
+        if (count > (len - pos) / 2 + 1) {
+                *status = PROB_IO_TOO_FEW;
+                return NULL;
+        }
+        prob_set_t *ps = prob_set_malloc(count);
+        for (size_t i=0; i<count; i++) {
+                while (pos < len && is_separator(text[pos])) {
+                        pos++;
+                }
+                if (pos == len) {
+                        *status = PROB_IO_TOO_FEW;
+                        prob_set_free(ps);
+                        return NULL;
+                }
+                bool negative = text[pos] == '-';
+                if (negative || text[pos] == '+') {
+                        pos++;
+                }
+                unsigned long long magnitude;
+                *status = parse_magnitude(text, len, &pos,
+                                          negative
+                                          ? (unsigned long long)LLONG_MAX + 1
+                                          : LLONG_MAX,
+                                          &magnitude);
+                if (*status == PROB_IO_OK && pos < len
+                    && !is_separator(text[pos])) {
+                        *status = PROB_IO_BAD_VALUE;
+                }
+                if (*status != PROB_IO_OK) {
+                        prob_set_free(ps);
+                        return NULL;
+                }
+                ps->item_vals[i] = negative ? (long long)(0 - magnitude)
+                                            : (long long)magnitude;
+        }
+        while (pos < len && (is_separator(text[pos]) || text[pos] == '\0')) {
+                pos++;
+        }
+        if (pos < len) {
+                *status = PROB_IO_TOO_MANY;
+                prob_set_free(ps);
+                return NULL;
+        }
+        return ps;
+}
+prob_set_t *prob_set_read(FILE *in, prob_io_status_t *status) {
+        size_t capacity = READ_CHUNK;
+        struct stat st;
+        if (fstat(fileno(in), &st) == 0 && S_ISREG(st.st_mode)
+            && st.st_size > 0) {
+                capacity = (size_t)st.st_size + 1;
+        }
+        char *text = malloc(capacity);
+        size_t len = 0;
+        size_t got;
+        while ((got = fread(text + len, 1, capacity - len, in)) > 0) {
+                len += got;
+                if (len == capacity) {
+                        capacity *= 2;
+                        text = realloc(text, capacity);
+                }
+        }
+        if (ferror(in)) {
+                free(text);
+                if (status != NULL) {
+                        *status = PROB_IO_READ_ERROR;
+                }
+                return NULL;
+        }
+        prob_set_t *ps = prob_set_parse(text, len, status);
+        free(text);
+        return ps;
+}
+const char *prob_io_strerror(prob_io_status_t status) {
+        switch (status) {
+        case PROB_IO_OK:
+                return "no error";
+        case PROB_IO_READ_ERROR:
+                return "input could not be read";
+        case PROB_IO_BAD_COUNT:
+                return "item count is not a non-negative integer";
+        case PROB_IO_BAD_VALUE:
+                return "item value is not an integer";
+        case PROB_IO_OVERFLOW:
+                return "number out of range";
+        case PROB_IO_TOO_FEW:
+                return "fewer item values than the item count";
+        case PROB_IO_TOO_MANY:
+                return "more item values than the item count";
+        case PROB_IO_WRITE_ERROR:
+                return "output could not be written";
+        case PROB_IO_BAD_FORMAT:
+                return "not a binary file of the expected kind";
+        case PROB_IO_BAD_CHECKSUM:
+                return "checksum mismatch";
+        }
+        return "unknown error";
+}
+
+static bool is_separator(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == ','
+               || c == '\v' || c == '\f';
+}
+static prob_io_status_t parse_magnitude(const char *text, size_t len,
+                                        size_t *pos, unsigned long long max,
+                                        unsigned long long *out) {
+        size_t p = *pos;
+        unsigned long long val = 0;
+        bool overflow = false;
+#if HAVE_SWAR_DIGITS
+        /* chunks are only loaded whole from inside the text */
+        while (len - p >= 8) {
+                uint64_t chunk;
+                memcpy(&chunk, text + p, sizeof(chunk));
+                if (!is_eight_digits(chunk)) {
+                        break;
+                }
+                uint32_t chunk_val = eight_digits_value(chunk);
+                if (val > (ULLONG_MAX - chunk_val) / 100000000) {
+                        overflow = true;
+                }
+                val = val * 100000000 + chunk_val;
+                p += 8;
+        }
+#endif
+        while (p < len && text[p] >= '0' && text[p] <= '9') {
+                unsigned digit = text[p] - '0';
+                if (val > (ULLONG_MAX - digit) / 10) {
+                        overflow = true;
+                }
+                val = val * 10 + digit;
+                p++;
+        }
+        if (p == *pos) {
+                return PROB_IO_BAD_VALUE;
+        }
+        *pos = p;
+        if (overflow || val > max) {
+                return PROB_IO_OVERFLOW;
+        }
+        *out = val;
+        return PROB_IO_OK;
+}
+static bool is_eight_digits(uint64_t chunk) {
+        /* a byte is a digit iff its high nibble is 3 and adding 6 does not
+         * carry into the high nibble */
+        return ((chunk & 0xF0F0F0F0F0F0F0F0ULL)
+                | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL)
+                   >> 4))
+               == 0x3333333333333333ULL;
+}
+static uint32_t eight_digits_value(uint64_t chunk) {
+        /* digits are combined pairwise into 2-, 4- and then 8-digit values
+         * with three multiplies */
+        const uint64_t mask = 0x000000FF000000FFULL;
+        const uint64_t mul1 = 100 + (1000000ULL << 32);
+        const uint64_t mul2 = 1 + (10000ULL << 32);
+        chunk -= 0x3030303030303030ULL;
+        chunk = (chunk * 10) + (chunk >> 8);
+        chunk = (((chunk & mask) * mul1)
+                 + (((chunk >> 16) & mask) * mul2)) >> 32;
+        return (uint32_t)chunk;
+}
+static int entry_cmp(const void *a, const void *b) {
+        const struct sort_entry *ea = (const struct sort_entry *)a;
+        const struct sort_entry *eb = (const struct sort_entry *)b;
+        if (ea->val != eb->val) {
+                return (ea->val > eb->val) ? -1 : 1;
+        }
+        return (ea->i > eb->i) - (ea->i < eb->i);
+}
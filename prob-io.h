@@ -0,0 +1,49 @@
+#ifndef PROB_IO_H
+#define PROB_IO_H
+/** Header file to load problem sets in the text format read by every
+ * driver: the number of items, then that many integer item values, all
+ * separated by white space or commas
+ * @file prob-io.h */
+
+#include "number-partition.h"
+#include <stdio.h>
+
+typedef enum prob_io_status prob_io_status_t;
+/** Outcome of loading a problem set */
+enum prob_io_status {
+        PROB_IO_OK,
+        /** The input could not be read */
+        PROB_IO_READ_ERROR,
+        /** The item count is missing or not a non-negative integer */
+        PROB_IO_BAD_COUNT,
+        /** A value is not an integer */
+        PROB_IO_BAD_VALUE,
+        /** A value (or the count) does not fit in a long long (size_t) */
+        PROB_IO_OVERFLOW,
+        /** Fewer values than the count */
+        PROB_IO_TOO_FEW,
+        /** Text left after the last value */
+        PROB_IO_TOO_MANY,
+        /** The output could not be written */
+        PROB_IO_WRITE_ERROR,
+        /** A binary file is truncated, of another byte order or not of the
+         * expected kind */
+        PROB_IO_BAD_FORMAT,
+        /** A binary file's contents do not match its checksum or belong to
+         * another problem set */
+        PROB_IO_BAD_CHECKSUM
+};
+
+/** Returns a problem set parsed from the len bytes of text, or NULL with
+ * status (if not NULL) telling why. Integers are parsed by hand, eight
+ * digits at a time where the machine allows it, rather than by scanf
+ * @post                result must be freed (via prob_set_free) */
+prob_set_t *prob_set_parse(const char *text, size_t len,
+                           prob_io_status_t *status);
+/** Reads all of in, with a single allocation if it is a regular file, and
+ * parses it as prob_set_parse does */
+prob_set_t *prob_set_read(FILE *in, prob_io_status_t *status);
+/** Returns a message describing status */
+const char *prob_io_strerror(prob_io_status_t status);
+
+#endif /* !PROB_IO_H */
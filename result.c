@@ -0,0 +1,71 @@
+/** Implements function prototypes in result.h
+ * @file result.c */
+#include "result.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Returns word w of the bitmap of set 0 or 1 of res, padding bits clear */
+static uint64_t set_word(const result_t *res, unsigned set, size_t w);
+
+result_t *result_malloc(const chrom_t *best_chrom,
+                        const long long *item_vals,
+                        size_t num_gens_passed) {
+        result_t *res = malloc(sizeof(*res));
+        res->num_gens_passed = num_gens_passed;
+        res->num_items = best_chrom->num_bits;
+        res->item_vals = item_vals;
+        res->words = malloc(sizeof(uint64_t)
+                            * BITS2WORDS(best_chrom->num_bits));
+        memcpy(res->words, best_chrom->words,
+               sizeof(uint64_t) * BITS2WORDS(best_chrom->num_bits));
+        size_t set1_count = 0;
+        __int128 sums[2] = {0, 0};
+        for (size_t i=0; i<best_chrom->num_bits; i++) {
+                unsigned bit = (best_chrom->words[i / WORD_BITS]
+                                >> (i % WORD_BITS)) & 1;
+                set1_count += bit;
+                sums[bit] += item_vals[i];
+        }
+        res->set0_count = best_chrom->num_bits - set1_count;
+        res->set1_count = set1_count;
+        res->set0_sum = sums[0];
+        res->set1_sum = sums[1];
+        return res;
+}
+void result_free(result_t *res) {
+        free(res->words);
+        free(res);
+}
+unsigned __int128 result_diff(const result_t *res) {
+        __int128 diff = res->set0_sum - res->set1_sum;
+        return (diff < 0) ? -(unsigned __int128)diff
+                          : (unsigned __int128)diff;
+}
+void result_iter_init(result_iter_t *it, const result_t *res, unsigned set) {
+        it->res = res;
+        it->set = set;
+        it->word_i = 0;
+        it->bits = (res->num_items > 0) ? set_word(res, set, 0) : 0;
+}
+bool result_iter_next(result_iter_t *it, long long *val) {
+        while (it->bits == 0) {
+                if (it->word_i + 1 >= BITS2WORDS(it->res->num_items)) {
+                        return false;
+                }
+                it->bits = set_word(it->res, it->set, ++it->word_i);
+        }
+        size_t i = it->word_i * WORD_BITS + __builtin_ctzll(it->bits);
+        it->bits &= it->bits - 1;
+        *val = it->res->item_vals[i];
+        return true;
+}
+static uint64_t set_word(const result_t *res, unsigned set, size_t w) {
+        if (set == 1) {
+                return res->words[w];
+        }
+        uint64_t word = ~res->words[w];
+        if (w == BITS2WORDS(res->num_items) - 1) {
+                word &= TAIL_MASK(res->num_items);
+        }
+        return word;
+}
@@ -0,0 +1,55 @@
+#ifndef RESULT_H
+#define RESULT_H
+/** Header file for the partition every solver returns, shared by the genetic
+ * algorithm and the differencing solvers so that programs using only the
+ * latter need not link the former
+ * @file result.h */
+
+#include "chromosome.h"
+
+typedef struct result result_t;
+/** Return structure of num_part_2way; the values of each set are not copied
+ * but visited through a result_iter_t */
+struct result {
+        size_t num_gens_passed;
+        size_t num_items;
+        size_t set0_count;
+        size_t set1_count;
+        __int128 set0_sum;
+        __int128 set1_sum;
+        /** Membership of every item in the chromosome layout: bit i of the
+         * words is set if item i is in set1 */
+        uint64_t *words;
+        /** Values of the problem set partitioned, which must outlive the
+         * result */
+        const long long *item_vals;
+};
+typedef struct result_iter result_iter_t;
+/** Iterator over the values of one set of a result, in item order */
+struct result_iter {
+        const result_t *res;
+        /** Set visited, 0 or 1 */
+        unsigned set;
+        /** Index of the word being visited */
+        size_t word_i;
+        /** Members of the set in that word not visited yet */
+        uint64_t bits;
+};
+
+/** Return a result structure based on the decidedly-best chromosome, in one
+ * pass over its bits; item_vals must outlive the result
+ * @post                result must be freed (via result_free) */
+result_t *result_malloc(const chrom_t *best_chrom,
+                        const long long *item_vals,
+                        size_t num_gens_passed);
+/** Frees a result structure returned by num_part_2way */
+void result_free(result_t *res);
+/** Returns |set0_sum - set1_sum| of a result in O(1) */
+unsigned __int128 result_diff(const result_t *res);
+/** Starts iterating over the values of set 0 or 1 of res */
+void result_iter_init(result_iter_t *it, const result_t *res, unsigned set);
+/** Stores the next value of the set in val; returns false, leaving val
+ * untouched, once every value was visited */
+bool result_iter_next(result_iter_t *it, long long *val);
+
+#endif /* !RESULT_H */
@@ -0,0 +1,97 @@
+/** Implements function prototypes in rng.h using xoshiro256** seeded through
+ * splitmix64
+ * @file rng.c */
+#include "rng.h"
+
+/** Rotates x left by k bits */
+static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+}
+/** Advances a splitmix64 state and returns its next output */
+static uint64_t splitmix64(uint64_t *state) {
+        uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+}
+/** Advances the generator as if rng_next were called the number of times
+ * encoded by the jump polynomial */
+static void jump_by(rng_t *rng, const uint64_t poly[4]) {
+        uint64_t s[4] = {0, 0, 0, 0};
+        for (int i=0; i<4; i++) {
+                for (int b=0; b<64; b++) {
+                        if (poly[i] & ((uint64_t)1 << b)) {
+                                for (int j=0; j<4; j++) {
+                                        s[j] ^= rng->s[j];
+                                }
+                        }
+                        rng_next(rng);
+                }
+        }
+        for (int j=0; j<4; j++) {
+                rng->s[j] = s[j];
+        }
+}
+
+void rng_seed(rng_t *rng, uint64_t seed) {
+        for (int i=0; i<4; i++) {
+                rng->s[i] = splitmix64(&seed);
+        }
+}
+void rng_seed_stream(rng_t *rng, uint64_t seed, uint64_t stream) {
+        rng_seed(rng, seed);
+        for (uint64_t i=0; i<stream; i++) {
+                rng_long_jump(rng);
+        }
+}
+uint64_t rng_next(rng_t *rng) {
+        uint64_t *s = rng->s;
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+}
+void rng_fill(rng_t *rng, uint64_t *words, size_t num_words) {
+        /* a local copy lets the state live in registers across the loop */
+        rng_t tmp = *rng;
+        for (size_t i=0; i<num_words; i++) {
+                words[i] = rng_next(&tmp);
+        }
+        *rng = tmp;
+}
+/* Lemire's multiply-shift method; the rejection loop only runs when the low
+ * half falls in the biased region, which is rare for small bounds */
+uint64_t rng_below(rng_t *rng, uint64_t bound) {
+        unsigned __int128 m = (unsigned __int128)rng_next(rng) * bound;
+        uint64_t low = (uint64_t)m;
+        if (low < bound) {
+                uint64_t threshold = -bound % bound;
+                while (low < threshold) {
+                        m = (unsigned __int128)rng_next(rng) * bound;
+                        low = (uint64_t)m;
+                }
+        }
+        return (uint64_t)(m >> 64);
+}
+double rng_unit(rng_t *rng) {
+        return ((double)(rng_next(rng) >> 11) + 0.5) / (double)(1ULL << 53);
+}
+void rng_jump(rng_t *rng) {
+        static const uint64_t poly[4] = {
+                0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+        };
+        jump_by(rng, poly);
+}
+void rng_long_jump(rng_t *rng) {
+        static const uint64_t poly[4] = {
+                0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL,
+                0x77710069854ee241ULL, 0x39109bb02acbe635ULL
+        };
+        jump_by(rng, poly);
+}
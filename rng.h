@@ -0,0 +1,39 @@
+#ifndef RNG_H
+#define RNG_H
+/** Defines a seedable pseudo-random number generator whose state is passed
+ * explicitly, so that runs can be reproduced and threads can each own an
+ * independent stream
+ * @file rng.h */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Typedef for struct rng */
+typedef struct rng rng_t;
+/** State of a xoshiro256** generator; never all zero once seeded */
+struct rng {
+        uint64_t s[4];
+};
+
+/** Seeds the generator from a single 64-bit value; equal seeds always
+ * produce equal sequences */
+void rng_seed(rng_t *rng, uint64_t seed);
+/** Seeds the generator to the stream-th independent stream of seed; streams
+ * are 2^192 outputs apart so they never overlap in practice */
+void rng_seed_stream(rng_t *rng, uint64_t seed, uint64_t stream);
+/** Returns 64 random bits */
+uint64_t rng_next(rng_t *rng);
+/** Fills num_words words with random bits */
+void rng_fill(rng_t *rng, uint64_t *words, size_t num_words);
+/** Returns a uniformly distributed integer in [0, bound)
+ * @pre                 bound > 0 */
+uint64_t rng_below(rng_t *rng, uint64_t bound);
+/** Returns a uniformly distributed double in (0, 1) */
+double rng_unit(rng_t *rng);
+/** Advances the generator by 2^128 outputs; used to split one stream into
+ * non-overlapping substreams, e.g. one per thread */
+void rng_jump(rng_t *rng);
+/** Advances the generator by 2^192 outputs */
+void rng_long_jump(rng_t *rng);
+
+#endif /* !RNG_H */
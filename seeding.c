@@ -0,0 +1,58 @@
+/** Implements the heuristic seeds of the initial population declared in
+ * ga-engine.h
+ * @file seeding.c */
+#include "ga-engine.h"
+#include "differencing.h"
+#include <stdlib.h>
+
+/** Writes the greedy partition over items in the given order into words:
+ * each item joins whichever set has the smaller sum so far */
+static void greedy_partition(const long long *item_vals, const size_t *order,
+                             size_t num_items, uint64_t *words);
+
+void seed_chrom(uint64_t *words, size_t k, const ga_ctx_t *ctx, rng_t *rng) {
+        size_t num_items = ctx->num_items;
+        if (k == 0) {
+                ldm_partition(ctx->item_vals, num_items, words);
+                return;
+        }
+        if (k == 1) {
+                greedy_partition(ctx->item_vals, ctx->sorted, num_items,
+                                 words);
+        } else {
+                /* swapping random neighbors keeps the large items early,
+                 * where greedy needs them, while varying every seed */
+                size_t *order = ga_malloc(sizeof(*order) * num_items);
+                for (size_t i=0; i<num_items; i++) {
+                        order[i] = ctx->sorted[i];
+                }
+                for (size_t i=0; i+1<num_items; i++) {
+                        if (rng_next(rng) & 1) {
+                                size_t tmp = order[i];
+                                order[i] = order[i + 1];
+                                order[i + 1] = tmp;
+                        }
+                }
+                greedy_partition(ctx->item_vals, order, num_items, words);
+                free(order);
+        }
+        words_normalize(words, num_items);
+}
+
+static void greedy_partition(const long long *item_vals, const size_t *order,
+                             size_t num_items, uint64_t *words) {
+        for (size_t w=0; w<BITS2WORDS(num_items); w++) {
+                words[w] = 0;
+        }
+        /* sum of set0 - sum of set1, exact for any instance */
+        __int128 diff = 0;
+        for (size_t k=0; k<num_items; k++) {
+                size_t i = order[k];
+                if (diff <= 0) {
+                        diff += item_vals[i];
+                } else {
+                        diff -= item_vals[i];
+                        words[i / WORD_BITS] |= (uint64_t)1 << (i % WORD_BITS);
+                }
+        }
+}
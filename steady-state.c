@@ -0,0 +1,327 @@
+/** Implements the steady-state engine declared in ga-engine.h. Rather than
+ * breeding a whole new population every generation, offspring are bred a few
+ * at a time from the current population and each replaces its least fit
+ * chromosome in place, so a fit offspring can become a parent as soon as it
+ * is evaluated and no copy of the best chromosome has to be kept aside.
+ *
+ * Offspring are bred in broods of FITNESS_GROUP so that those too far from
+ * their parents to be evaluated incrementally still go through
+ * fitness_diff_batch together; the parents of a brood are drawn before any
+ * of its offspring replace a chromosome.
+ * @file steady-state.c */
+#include "ga-engine.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Marks an empty slot of the duplicate table */
+#define DUP_EMPTY               SIZE_MAX
+
+/** Entry of the duplicate table */
+struct dup_slot {
+        uint64_t hash;
+        /** Index of the chromosome, or DUP_EMPTY */
+        size_t chrom;
+};
+/** State of a steady-state run */
+struct steady {
+        pop_arena_t *pop;
+        /** Offspring of the current brood */
+        pop_arena_t *brood;
+        /** Max-heap of the chromosome indices of pop by unfitness, ties by
+         * index, so that heap[0] is the least fit chromosome */
+        size_t *heap;
+        /** Hash of the bits of each chromosome of pop */
+        uint64_t *hashes;
+        /** Every chromosome of pop by hash, open-addressed with linear
+         * probing and at most half full */
+        struct dup_slot *slots;
+        /** Number of slots minus 1; the number of slots is a power of 2 */
+        size_t slot_mask;
+};
+
+/** Returns whether chromosome i of pop goes above chromosome j in the heap:
+ * it is less fit or, as fit, has a higher index */
+static bool less_fit(const pop_arena_t *pop, size_t i, size_t j);
+/** Moves the k-th entry of the heap down until neither of its children is
+ * less fit */
+static void heap_sift_down(struct steady *st, size_t k);
+/** Adds chromosome i of the population, whose bits hash to hash, to the
+ * duplicate table */
+static void dup_insert(struct steady *st, size_t i, uint64_t hash);
+/** Removes chromosome i of the population from the duplicate table,
+ * shifting back the entries probed past it so that no tombstone is left */
+static void dup_remove(struct steady *st, size_t i);
+/** Returns whether a chromosome of the population has the same bits as
+ * words, which hash to hash */
+static bool dup_contains(const struct steady *st, const uint64_t *words,
+                         uint64_t hash);
+/** Returns the winner of a tournament of ctx->tourn_size chromosomes drawn
+ * from pop; ties go to the first drawn */
+static size_t tourn_draw(const pop_arena_t *pop, const ga_ctx_t *ctx,
+                         rng_t *rng);
+/** Overwrites the first brood_size chromosomes of the brood with offspring
+ * of parents drawn from the population, mutating and evaluating them as
+ * new_gen does; *num_misses counts the offspring in a row too far from
+ * their parents for incremental evaluation */
+static void breed(struct steady *st, size_t brood_size, const ga_ctx_t *ctx,
+                  rng_t *rng, size_t *num_misses, double *phase_seconds);
+/** Replaces the least fit chromosome of the population with offspring c of
+ * the brood if the offspring is fitter and not a duplicate, keeping *best_i
+ * the index of the fittest chromosome */
+static void replace_worst(struct steady *st, size_t c, size_t *best_i);
+/** Completes rec with generation gen, whose population is pop, and
+ * num_allocs allocations, adds it to ctx->trace and clears its timers */
+static void record_gen(const ga_ctx_t *ctx, ga_gen_record_t *rec, size_t gen,
+                       const pop_arena_t *pop, size_t num_allocs);
+
+result_t *num_part_2way_steady(const prob_set_t *ps,
+                               const ga_params_t *params,
+                               const ga_ctx_t *ctx, ga_stats_t *stats) {
+        const size_t pop_size = ctx->pop_size;
+        if (stats != NULL) {
+                *stats = (ga_stats_t){0};
+        }
+        ga_gen_record_t rec = {0};
+        double *timers = (ctx->trace != NULL) ? rec.phase_seconds : NULL;
+        struct timespec lap;
+        size_t num_allocs = ga_num_allocs;
+        size_t num_slots = 1;
+        while (num_slots < 2 * pop_size) {
+                num_slots *= 2;
+        }
+        /* every allocation of the run happens here */
+        struct steady st = {
+                .pop = pop_arena_malloc(pop_size, ps->num_items),
+                .brood = pop_arena_malloc(FITNESS_GROUP, ps->num_items),
+                .heap = ga_malloc(sizeof(size_t) * pop_size),
+                .hashes = ga_malloc(sizeof(uint64_t) * pop_size),
+                .slots = ga_malloc(sizeof(struct dup_slot) * num_slots),
+                .slot_mask = num_slots - 1
+        };
+        for (size_t s=0; s<num_slots; s++) {
+                st.slots[s].chrom = DUP_EMPTY;
+        }
+        /* the same stream, and so the same initial population, as thread 0
+         * of the general engine */
+        rng_t rng;
+        rng_seed_stream(&rng, params->seed, params->stream);
+        initial_pop(st.pop, 0, pop_size, ctx, &rng);
+        for (size_t i=0; i<pop_size; i++) {
+                st.heap[i] = i;
+                dup_insert(&st, i, words_hash(ARENA_CHROM(st.pop, i),
+                                              st.pop->num_bits));
+        }
+        for (size_t k=pop_size/2; k>0; k--) {
+                heap_sift_down(&st, k - 1);
+        }
+        size_t best_i = find_fittest(st.pop, 0, pop_size);
+        if (timers != NULL) {
+                record_gen(ctx, &rec, 0, st.pop, ga_num_allocs - num_allocs);
+        }
+        size_t num_gens_passed = 1;
+        size_t stall_gens = 0;
+        bool past_deadline = false;
+        while (!ga_converged(ctx, num_gens_passed,
+                             st.pop->unfitness[best_i], stall_gens)
+               && !past_deadline) {
+                long long prev_unfitness = st.pop->unfitness[best_i];
+                num_allocs = ga_num_allocs;
+                size_t num_misses = 0;
+                /* the target is checked after every brood rather than at
+                 * the end of the generation */
+                for (size_t n=0; n<pop_size
+                     && st.pop->unfitness[best_i] > ctx->target_diff;
+                     n+=FITNESS_GROUP) {
+                        size_t brood_size = (pop_size - n < FITNESS_GROUP)
+                                            ? pop_size - n
+                                            : FITNESS_GROUP;
+                        breed(&st, brood_size, ctx, &rng, &num_misses,
+                              timers);
+                        ga_lap_start(timers, &lap);
+                        for (size_t c=0; c<brood_size; c++) {
+                                replace_worst(&st, c, &best_i);
+                        }
+                        ga_lap(timers, GA_PHASE_FITTEST, &lap);
+                }
+                past_deadline = ga_past_deadline(ctx);
+                stall_gens = (st.pop->unfitness[best_i] < prev_unfitness)
+                             ? 0
+                             : stall_gens + 1;
+                if (timers != NULL) {
+                        record_gen(ctx, &rec, num_gens_passed, st.pop,
+                                   ga_num_allocs - num_allocs);
+                }
+                num_gens_passed++;
+        }
+        chrom_t *best_chrom = chrom_malloc(ps->num_items);
+        memcpy(best_chrom->words, ARENA_CHROM(st.pop, best_i),
+               sizeof(uint64_t) * st.pop->stride);
+        best_chrom->unfitness = st.pop->unfitness[best_i];
+        result_t *res = result_malloc(best_chrom, ps->item_vals,
+                                      num_gens_passed);
+        chrom_free(best_chrom);
+        free(st.slots);
+        free(st.hashes);
+        free(st.heap);
+        pop_arena_free(st.brood);
+        pop_arena_free(st.pop);
+        return res;
+}
+
+static bool less_fit(const pop_arena_t *pop, size_t i, size_t j) {
+        return pop->unfitness[i] > pop->unfitness[j]
+               || (pop->unfitness[i] == pop->unfitness[j] && i > j);
+}
+static void heap_sift_down(struct steady *st, size_t k) {
+        size_t n = st->pop->num_chroms;
+        size_t entry = st->heap[k];
+        while (2 * k + 1 < n) {
+                size_t child = 2 * k + 1;
+                if (child + 1 < n && less_fit(st->pop, st->heap[child + 1],
+                                              st->heap[child])) {
+                        child++;
+                }
+                if (!less_fit(st->pop, st->heap[child], entry)) {
+                        break;
+                }
+                st->heap[k] = st->heap[child];
+                k = child;
+        }
+        st->heap[k] = entry;
+}
+static void dup_insert(struct steady *st, size_t i, uint64_t hash) {
+        st->hashes[i] = hash;
+        size_t s = hash & st->slot_mask;
+        while (st->slots[s].chrom != DUP_EMPTY) {
+                s = (s + 1) & st->slot_mask;
+        }
+        st->slots[s].hash = hash;
+        st->slots[s].chrom = i;
+}
+static void dup_remove(struct steady *st, size_t i) {
+        size_t hole = st->hashes[i] & st->slot_mask;
+        while (st->slots[hole].chrom != i) {
+                hole = (hole + 1) & st->slot_mask;
+        }
+        /* an entry further along the run may fill the hole if the hole lies
+         * between the entry's home slot and the entry itself */
+        for (size_t s=(hole+1)&st->slot_mask; st->slots[s].chrom!=DUP_EMPTY;
+             s=(s+1)&st->slot_mask) {
+                size_t home = st->slots[s].hash & st->slot_mask;
+                if (((s - home) & st->slot_mask)
+                    >= ((s - hole) & st->slot_mask)) {
+                        st->slots[hole] = st->slots[s];
+                        hole = s;
+                }
+        }
+        st->slots[hole].chrom = DUP_EMPTY;
+}
+static bool dup_contains(const struct steady *st, const uint64_t *words,
+                         uint64_t hash) {
+        for (size_t s=hash&st->slot_mask; st->slots[s].chrom!=DUP_EMPTY;
+             s=(s+1)&st->slot_mask) {
+                if (st->slots[s].hash == hash
+                    && memcmp(ARENA_CHROM(st->pop, st->slots[s].chrom), words,
+                              sizeof(uint64_t) * st->pop->stride) == 0) {
+                        return true;
+                }
+        }
+        return false;
+}
+static size_t tourn_draw(const pop_arena_t *pop, const ga_ctx_t *ctx,
+                         rng_t *rng) {
+        size_t winner = rng_below(rng, pop->num_chroms);
+        for (size_t k=1; k<ctx->tourn_size; k++) {
+                size_t other = rng_below(rng, pop->num_chroms);
+                if (pop->unfitness[winner] > pop->unfitness[other]) {
+                        winner = other;
+                }
+        }
+        return winner;
+}
+static void breed(struct steady *st, size_t brood_size, const ga_ctx_t *ctx,
+                  rng_t *rng, size_t *num_misses, double *phase_seconds) {
+        const pop_arena_t *pop = st->pop;
+        pop_arena_t *brood = st->brood;
+        struct timespec lap;
+        ga_lap_start(phase_seconds, &lap);
+        size_t pending[FITNESS_GROUP];
+        size_t num_pending = 0;
+        for (size_t c=0; c<brood_size; c++) {
+                size_t p1i = tourn_draw(pop, ctx, rng);
+                size_t p2i = tourn_draw(pop, ctx, rng);
+                ga_lap(phase_seconds, GA_PHASE_SELECT, &lap);
+                uint64_t *child = ARENA_CHROM(brood, c);
+                const uint64_t *p1 = ARENA_CHROM(pop, p1i);
+                const uint64_t *p2 = ARENA_CHROM(pop, p2i);
+                switch (ctx->crossover) {
+                case CROSSOVER_ONE_POINT:
+                        words_1px(child, p1, p2, brood->num_bits, rng);
+                        break;
+                case CROSSOVER_TWO_POINT:
+                        words_2px(child, p1, p2, brood->num_bits, rng);
+                        break;
+                default:
+                        words_ucx(child, p1, p2, brood->num_bits, rng);
+                        break;
+                }
+                words_normalize(child, brood->num_bits);
+                words_mutate(child, brood->num_bits, ctx->mutation_rate,
+                             rng);
+                words_normalize(child, brood->num_bits);
+                long long diff;
+                bool try_delta = ctx->delta_fitness
+                                 && *num_misses < DELTA_FITNESS_PROBES;
+                if (try_delta && !child_diff_from_parents(pop, p1i, p2i,
+                                                          child, ctx,
+                                                          &diff)) {
+                        (*num_misses)++;
+                        try_delta = false;
+                }
+                if (try_delta) {
+                        *num_misses = 0;
+                        brood->diff[c] = diff;
+                        brood->unfitness[c] = (diff < 0) ? -diff : diff;
+                } else {
+                        pending[num_pending++] = c;
+                }
+                ga_lap(phase_seconds, GA_PHASE_BREED, &lap);
+        }
+        if (num_pending > 0) {
+                calc_fitness_group(brood, pending, num_pending, ctx);
+                ga_lap(phase_seconds, GA_PHASE_FITNESS, &lap);
+        }
+}
+static void replace_worst(struct steady *st, size_t c, size_t *best_i) {
+        pop_arena_t *pop = st->pop;
+        const uint64_t *child = ARENA_CHROM(st->brood, c);
+        size_t worst_i = st->heap[0];
+        if (st->brood->unfitness[c] >= pop->unfitness[worst_i]) {
+                return;
+        }
+        uint64_t hash = words_hash(child, pop->num_bits);
+        if (dup_contains(st, child, hash)) {
+                return;
+        }
+        dup_remove(st, worst_i);
+        memcpy(ARENA_CHROM(pop, worst_i), child,
+               sizeof(uint64_t) * pop->stride);
+        pop->diff[worst_i] = st->brood->diff[c];
+        pop->unfitness[worst_i] = st->brood->unfitness[c];
+        dup_insert(st, worst_i, hash);
+        heap_sift_down(st, 0);
+        if (pop->unfitness[worst_i] < pop->unfitness[*best_i]) {
+                *best_i = worst_i;
+        }
+}
+static void record_gen(const ga_ctx_t *ctx, ga_gen_record_t *rec, size_t gen,
+                       const pop_arena_t *pop, size_t num_allocs) {
+        rec->gen = gen;
+        rec->island = 0;
+        ga_record_pop(rec, pop, ctx);
+        rec->num_allocs = num_allocs;
+        ga_trace_add(ctx->trace, rec);
+        for (size_t p=0; p<GA_NUM_PHASES; p++) {
+                rec->phase_seconds[p] = 0;
+        }
+}